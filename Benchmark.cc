@@ -0,0 +1,391 @@
+///@file
+///@brief Benchmark driver that times every phase of the contour pipeline on seeded synthetic workloads and reports the results as JSON
+///
+///Build with: g++ -O2 -std=c++17 -pthread Benchmark.cc Contours.cc -o benchmark
+#include "Contours.h"
+#include<bits/stdc++.h>
+using namespace std;
+typedef long long int ll;
+
+///Brief description of workload generator
+///
+///A named function producing n rectangles from a seeded random generator
+typedef struct workload
+{
+    ///Name used on the command line and in the report
+    const char* name;
+    ///Produces the rectangles, with IDs given in order
+    vector<rectangle> (*generate)(size_t n, mt19937_64& rng);
+}workload;
+
+///Side of the square that all workloads are drawn in
+const ll SPAN = 1LL<<30;
+
+/*! Builds a rectangle from its bounds
+    \param x1 left bound
+    \param x2 right bound
+    \param y1 bottom bound
+    \param y2 top bound
+    \param id unique ID of the rectangle
+    \return The rectangle, with empty extents widened to one unit
+*/
+rectangle make_rectangle(ll x1, ll x2, ll y1, ll y2, ll id)
+{
+    rectangle r;
+    r.x_int.bottom = x1;
+    r.x_int.top = max(x2,x1+1);
+    r.y_int.bottom = y1;
+    r.y_int.top = max(y2,y1+1);
+    r.id = id;
+    return r;
+}
+
+/*! Uniformly placed rectangles whose sides average a few times the mean spacing, so that neighbours overlap moderately
+    \param n number of rectangles
+    \param rng seeded random generator
+    \return The generated rectangles
+*/
+vector<rectangle> gen_uniform(size_t n, mt19937_64& rng)
+{
+    ll side = max<ll>(SPAN/(ll)sqrt((double)n)*2,2);
+    uniform_int_distribution<ll> pos(0,SPAN), len(1,side);
+    vector<rectangle> rects;
+    for(size_t i=0;i<n;i++)
+    {
+        ll x = pos(rng), y = pos(rng);
+        rects.push_back(make_rectangle(x, x+len(rng), y, y+len(rng), i));
+    }
+    return rects;
+}
+
+/*! Concentric rectangles shrinking towards the centre with jittered margins, the worst case for the number of stripes
+    \param n number of rectangles
+    \param rng seeded random generator
+    \return The generated rectangles
+*/
+vector<rectangle> gen_nested(size_t n, mt19937_64& rng)
+{
+    ll step = max<ll>(SPAN/(2*(ll)n+2),2);
+    uniform_int_distribution<ll> jitter(0,step/2);
+    vector<rectangle> rects;
+    for(size_t i=0;i<n;i++)
+    {
+        ll d = (ll)i*step;
+        rects.push_back(make_rectangle(d+jitter(rng), SPAN-d-jitter(rng), d+jitter(rng), SPAN-d-jitter(rng), i));
+    }
+    return rects;
+}
+
+/*! Disjoint rectangles, one per cell of a square grid with a gap between cells, so the contour has four segments per rectangle
+    \param n number of rectangles
+    \param rng seeded random generator
+    \return The generated rectangles
+*/
+vector<rectangle> gen_grid(size_t n, mt19937_64& rng)
+{
+    ll k = max<ll>((ll)ceil(sqrt((double)n)),1);
+    ll cell = max<ll>(SPAN/k,8);
+    uniform_int_distribution<ll> gap(cell/10, cell/4);
+    vector<rectangle> rects;
+    for(size_t i=0;i<n;i++)
+    {
+        ll cx = (ll)i%k, cy = (ll)i/k;
+        rects.push_back(make_rectangle(cx*cell+gap(rng), (cx+1)*cell-gap(rng), cy*cell+gap(rng), (cy+1)*cell-gap(rng), i));
+    }
+    return rects;
+}
+
+/*! Overlapping buildings standing on a common baseline, their heights following a random walk, which gives a long staircase contour
+    \param n number of rectangles
+    \param rng seeded random generator
+    \return The generated rectangles
+*/
+vector<rectangle> gen_skyline(size_t n, mt19937_64& rng)
+{
+    ll w = max<ll>(SPAN/(ll)n,4);
+    uniform_int_distribution<ll> width(w, 3*w), walk(-SPAN/64, SPAN/64);
+    ll h = SPAN/2;
+    vector<rectangle> rects;
+    for(size_t i=0;i<n;i++)
+    {
+        h = min(max(h+walk(rng), SPAN/16), SPAN);
+        ll x = (ll)i*w;
+        rects.push_back(make_rectangle(x, x+width(rng), 0, h, i));
+    }
+    return rects;
+}
+
+/*! Long thin rectangles, half of them horizontal and half vertical, crossing each other many times
+    \param n number of rectangles
+    \param rng seeded random generator
+    \return The generated rectangles
+*/
+vector<rectangle> gen_slivers(size_t n, mt19937_64& rng)
+{
+    uniform_int_distribution<ll> pos(0,SPAN), len(SPAN/8,SPAN/2), thin(1,16);
+    vector<rectangle> rects;
+    for(size_t i=0;i<n;i++)
+    {
+        ll a = pos(rng), b = pos(rng);
+        if(i%2 == 0)
+        {
+            rects.push_back(make_rectangle(a, a+len(rng), b, b+thin(rng), i));
+        }
+        else
+        {
+            rects.push_back(make_rectangle(b, b+thin(rng), a, a+len(rng), i));
+        }
+    }
+    return rects;
+}
+
+/*! Small rectangles gathered around a few hotspots with normally distributed offsets, dense in the middle of every cluster and sparse between clusters
+    \param n number of rectangles
+    \param rng seeded random generator
+    \return The generated rectangles
+*/
+vector<rectangle> gen_clustered(size_t n, mt19937_64& rng)
+{
+    size_t clusters = max<size_t>(n/1000,1);
+    uniform_int_distribution<ll> pos(0,SPAN), len(1,SPAN/256);
+    normal_distribution<double> offset(0.0, SPAN/64.0);
+    vector<pair<ll,ll>> centres(clusters);
+    for(size_t c=0;c<clusters;c++)
+    {
+        centres[c] = {pos(rng), pos(rng)};
+    }
+    vector<rectangle> rects;
+    for(size_t i=0;i<n;i++)
+    {
+        const pair<ll,ll>& c = centres[rng()%clusters];
+        ll x = c.first+(ll)offset(rng), y = c.second+(ll)offset(rng);
+        rects.push_back(make_rectangle(x, x+len(rng), y, y+len(rng), i));
+    }
+    return rects;
+}
+
+///Global variable to store every workload the benchmark knows
+const workload WORKLOADS[] = {
+    {"uniform", gen_uniform},
+    {"nested", gen_nested},
+    {"grid", gen_grid},
+    {"skyline", gen_skyline},
+    {"slivers", gen_slivers},
+    {"clustered", gen_clustered},
+};
+
+///Brief description of phase timer
+///
+///Collects the wall time of the phases of one run, in the order they were measured
+typedef struct phase_timer
+{
+    vector<pair<string,double>> phases;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    ///Closes the phase that started at the previous call, or at construction
+    void lap(const string& name)
+    {
+        chrono::steady_clock::time_point now = chrono::steady_clock::now();
+        phases.push_back({name, chrono::duration<double>(now-start).count()});
+        start = now;
+    }
+}phase_timer;
+
+/*! Runs the whole pipeline once and appends its report as a JSON object
+    \param json stream receiving the report
+    \param w the workload to generate
+    \param n number of rectangles
+    \param seed seed of the random generator
+    \param engine the engine computing the contour; it is reused across runs, as a service embedding the library would
+    \param write_csv whether the csv_writer phase runs
+*/
+void run_once(ostream& json, const workload& w, size_t n, unsigned long long seed, contour_engine& engine, bool write_csv)
+{
+    mt19937_64 rng(seed);
+    vector<rectangle> rects = w.generate(n, rng);
+    stringstream text;
+    text << rects.size() << "\n";
+    for(size_t i=0;i<rects.size();i++)
+    {
+        text << rects[i].x_int.bottom << " " << rects[i].x_int.top << " " << rects[i].y_int.bottom << " " << rects[i].y_int.top << "\n";
+    }
+
+    string input = text.str();
+
+    phase_timer t;
+    vector<rectangle> input_rects;
+    parse_rectangles(input.data(), input.data()+input.size(), input_rects);
+    t.lap("input");
+
+    contour_result contours;
+    engine.compute(input_rects.data(), input_rects.size(), contours);
+    const engine_report& report = engine.report();
+    for(const pair<const char*,double>& phase : report.phases)
+    {
+        t.phases.push_back(phase);
+    }
+    t.start = chrono::steady_clock::now();
+    if(write_csv)
+    {
+        csv_writer(input_rects, contours.horizontal, contours.vertical);
+        t.lap("csv_writer");
+    }
+
+    double total = 0;
+    json << "    {\"workload\": \"" << w.name << "\", \"n\": " << n << ", \"seed\": " << seed;
+    json << ", \"engine\": \"" << (engine.options().algorithm == ENGINE_SWEEP ? "sweep" : "dac") << "\"";
+    json << ", \"stripes\": " << report.stripes << ", \"ctree_nodes\": " << report.ctree_nodes;
+    json << ", \"pieces\": " << report.pieces << ", \"horizontal\": " << contours.horizontal.size() << ", \"vertical\": " << contours.vertical.size();
+    json << ", \"phases\": {";
+    for(size_t k=0;k<t.phases.size();k++)
+    {
+        json << (k ? ", " : "") << "\"" << t.phases[k].first << "\": " << t.phases[k].second;
+        total += t.phases[k].second;
+    }
+    json << "}, \"total\": " << total << "}";
+}
+
+/*! Splits a comma separated list
+    \param list the text to split
+    \return The non empty items of the list
+*/
+vector<string> split_list(const string& list)
+{
+    vector<string> items;
+    stringstream in(list);
+    string item;
+    while(getline(in, item, ','))
+    {
+        if(!item.empty())
+        {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+/*! Prints the command line options understood by the benchmark
+    \param prog name the program was started with
+*/
+void usage(const char* prog)
+{
+    cerr << "usage: " << prog << " [options] > results.json\n";
+    cerr << "  --min-n N         smallest input size (default 1000)\n";
+    cerr << "  --max-n N         largest input size; sizes grow by 10x from min-n (default 100000, up to 10000000)\n";
+    cerr << "  --workloads LIST  comma separated: uniform,nested,grid,skyline,slivers,clustered (default: all)\n";
+    cerr << "  --engines LIST    comma separated: dac,sweep (default: dac)\n";
+    cerr << "  --seed S          seed of the generators (default 1)\n";
+    cerr << "  --repeat R        runs per configuration, each with the next seed (default 1)\n";
+    cerr << "  --threads N       worker threads (default: all cores)\n";
+    cerr << "  --no-csv          skip the csv_writer phase\n";
+}
+
+int main(int argc, char** argv)
+{
+    size_t min_n = 1000, max_n = 100000, repeat = 1;
+    unsigned long long seed = 1;
+    size_t threads = max<unsigned>(thread::hardware_concurrency(),1);
+    bool write_csv = true;
+    vector<string> workloads, engines = {"dac"};
+    for(const workload& w : WORKLOADS)
+    {
+        workloads.push_back(w.name);
+    }
+    for(int a=1;a<argc;a++)
+    {
+        string opt = argv[a];
+        if(a+1 < argc and opt == "--min-n")
+        {
+            min_n = max(atoll(argv[++a]),1LL);
+        }
+        else if(a+1 < argc and opt == "--max-n")
+        {
+            max_n = max(atoll(argv[++a]),1LL);
+        }
+        else if(a+1 < argc and opt == "--workloads")
+        {
+            workloads = split_list(argv[++a]);
+        }
+        else if(a+1 < argc and opt == "--engines")
+        {
+            engines = split_list(argv[++a]);
+        }
+        else if(a+1 < argc and opt == "--seed")
+        {
+            seed = strtoull(argv[++a], NULL, 10);
+        }
+        else if(a+1 < argc and opt == "--repeat")
+        {
+            repeat = max(atoll(argv[++a]),1LL);
+        }
+        else if(a+1 < argc and opt == "--threads")
+        {
+            threads = max(atoll(argv[++a]),1LL);
+        }
+        else if(opt == "--no-csv")
+        {
+            write_csv = false;
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    for(const string& e : engines)
+    {
+        if(e != "dac" and e != "sweep")
+        {
+            cerr << "unknown engine " << e << "\n";
+            return 1;
+        }
+    }
+    vector<const workload*> selected;
+    for(const string& name : workloads)
+    {
+        const workload* found = NULL;
+        for(const workload& w : WORKLOADS)
+        {
+            if(name == w.name)
+            {
+                found = &w;
+            }
+        }
+        if(found == NULL)
+        {
+            cerr << "unknown workload " << name << "\n";
+            return 1;
+        }
+        selected.push_back(found);
+    }
+
+    //one engine per algorithm, so that later runs reuse the memory of earlier ones; the sweep runs on one core and needs no pool
+    engine_options options;
+    options.threads = threads;
+    contour_engine dac(options);
+    options.algorithm = ENGINE_SWEEP;
+    options.threads = 1;
+    contour_engine sweep(options);
+
+    cout << setprecision(6) << fixed;
+    cout << "{\n  \"benchmark\": \"contours\",\n  \"threads\": " << threads << ",\n  \"results\": [\n";
+    bool first = true;
+    for(const workload* w : selected)
+    {
+        for(size_t n=min_n;n<=max_n;n*=10)
+        {
+            for(const string& e : engines)
+            {
+                for(size_t r=0;r<repeat;r++)
+                {
+                    cout << (first ? "" : ",\n");
+                    first = false;
+                    run_once(cout, *w, n, seed+r, e == "sweep" ? sweep : dac, write_csv);
+                    cout.flush();
+                }
+            }
+        }
+    }
+    cout << "\n  ]\n}\n";
+    return 0;
+}
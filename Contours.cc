@@ -1,209 +1,439 @@
 ///@file
 ///@brief This file contains a complete working implementation of R.H Guting's divide and conquer algorithm that helps solve the contour problem
+///
+///It is the contour library declared in Contours.h; the command line driver lives in Main.cc
+#include "Contours.h"
 #include<bits/stdc++.h>
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/mman.h>
+#include<sys/socket.h>
+#include<sys/stat.h>
+#include<sys/wait.h>
 using namespace std;
 typedef long long int ll;
-///Brief description of points class
+///Brief description of edge tag enumeration
 ///
-///The point structure contains two integers, representing the x and y coordinates of the point in 2D space
-typedef struct point
+///Tags the side of a rectangle that an edge lies on, and the kind of a node in the x union tree. Stored in a single byte so that edges and tree nodes stay compact and tag comparisons are integer comparisons
+enum edge_tag : uint8_t
 {
-    ll x,y;
-}point;
+    TOP,
+    BOTTOM,
+    LEFT,
+    RIGHT,
+    ///Marks an internal node of a ctree, which is neither a left nor a right edge
+    UNDEF
+};
 
-///Brief description of interval structure
+///Brief description of edge structure
 ///
-///This structure contains two integers, representing the minimum coordinate and the maximum coordinate that is spanned by the interval.
-typedef struct interval
+///This structure contains an integer that defines a fixed point, an interval between which it spans, an edge type, and the unique ID representing the rectangle to which it belongs.
+///The coordinate type is a parameter: the sweep uses 64 bit edges, the divide and conquer 32 bit ones whenever the input allows. The fields are ordered so that a 64 bit edge packs into 32 bytes and a 32 bit edge into 20, letting several edges share a cache line during the sort and the divide step of stripes
+template<class C> struct basic_edge
 {
-    ///Represents the smaller coordinate
-    ll bottom;
-    ///Represents the larger coordinate    
-    ll top;
-    ///Definition of comparator to facilitate set insertions in a sorted order
+    ///The fixed coordinate of the edge
+    C x;
+    ///The interval defines the length of the edge, and the minimum and maximum values that the variable coordinate can take
+    basic_interval<C> i;
+    ///Unique ID that was given to the rectangle containing this edge
+    int32_t rect_id;
+    ///The type of the edge - either TOP, BOTTOM, LEFT or RIGHT
+    edge_tag edgetype;
+    ///Definition of comparator to facilitate sorting; left edges come before right edges at the same x
     ///
-    bool operator<(const interval& e) const
-    { 
-        if(this->bottom<e.bottom)
+    bool operator<(const basic_edge& e) const
+    {
+        if(x != e.x)
+        {
+            return x < e.x;
+        }
+        if(edgetype == LEFT and e.edgetype == RIGHT)
         {
             return true;
         }
-        else if(this->bottom==e.bottom)
+        if(edgetype == RIGHT and e.edgetype == LEFT)
+        {
+            return false;
+        }
+        return i < e.i;
+    }
+};
+///Edge of 64 bit coordinates
+typedef basic_edge<ll> edge;
+static_assert(sizeof(edge) <= 32, "edge must fit in 32 bytes");
+static_assert(sizeof(basic_edge<int32_t>) <= 20, "32 bit edges must fit in 20 bytes");
+
+///Brief description of coordinate rank type
+///
+///Position of a coordinate among the sorted, distinct coordinates of its axis. When the coordinates themselves do not fit in 32 bits, the divide and conquer runs on their ranks instead; the contour pieces it produces are mapped back to coordinates at the end
+typedef int32_t rank_t;
+
+///Brief description of coordinate ranks
+///
+///The sorted, distinct coordinates of both axes: rank k of an axis stands for its k-th coordinate
+typedef struct coordinate_ranks
+{
+    ///Distinct x coordinates, sorted
+    vector<ll> xs;
+    ///Distinct y coordinates, sorted
+    vector<ll> ys;
+}coordinate_ranks;
+
+///Brief description of ctree structure
+///
+///Used to represent the x union datatype present in stripes data structure. Used to store a range of intervals in the form of a binary search tree
+template<class C> struct ctree
+{
+    ///Represents the value of the node in the tree, used to decide whether to move to the left or the right of the tree during inorder traversal
+    C x;
+    ///The type of the node - LEFT or RIGHT for a leaf holding an edge, UNDEF for an internal node; with 32 bit coordinates it shares the word of x
+    edge_tag lru;
+    ///The tree representing the left subtree of this node x
+    ctree* lson;
+    ///The tree representing the right subtree of this node x
+    ctree* rson;
+    ///Parameterized constructor to intiialize the values of the tree
+    ctree(C x, edge_tag lru, ctree* lson, ctree* rson)
+    {
+        this->x=x;
+        this->lru=lru;
+        this->lson=lson;
+        this->rson=rson;
+    }
+};
+static_assert(sizeof(ctree<int32_t>) <= 24, "32 bit ctree nodes must fit in 24 bytes");
+
+
+///Brief description of ctree arena
+///
+///Hands out ctree nodes from contiguous slabs that belong to one contour computation. The x union trees of different stripes share subtrees, so nodes are never freed one by one; instead every node is released at once when the arena is reset or destroyed
+template<class C> class ctree_arena
+{
+public:
+    ///Number of nodes carved out of every slab
+    static const size_t SLAB_NODES = 4096;
+
+    ctree_arena() : current(0), used(SLAB_NODES), nodes(0) {}
+    ctree_arena(const ctree_arena&) = delete;
+    ctree_arena& operator=(const ctree_arena&) = delete;
+    ~ctree_arena()
+    {
+        for(size_t i=0;i<slabs.size();i++)
+        {
+            ::operator delete(slabs[i]);
+        }
+    }
+
+    ///Constructs a new node inside the current slab, opening another slab when it is full
+    ctree<C>* make(C x, edge_tag lru, ctree<C>* lson, ctree<C>* rson)
+    {
+        if(used == SLAB_NODES)
         {
-            if(this->top<e.top)
+            if(current + 1 < slabs.size())
             {
-                return true;
+                current++;
             }
             else
             {
-                return false;
+                slabs.push_back((ctree<C>*)::operator new(SLAB_NODES*sizeof(ctree<C>)));
+                current = slabs.size()-1;
             }
+            used = 0;
         }
-        else
+        nodes++;
+        return new (slabs[current] + used++) ctree<C>(x, lru, lson, rson);
+    }
+
+    ///Releases every node handed out so far. The slabs are kept and reused by the next computation
+    void reset()
+    {
+        current = 0;
+        used = slabs.empty() ? SLAB_NODES : 0;
+        nodes = 0;
+        for(size_t i=0;i<workers.size();i++)
         {
-            return false;
+            workers[i]->reset();
         }
     }
-}interval;
 
-///Brief description of line segment structure
-///
-///This structure contains a fixed coordinate x and an interval which represents the range of coordinates on the alternate axis from x
-typedef struct line_segment
-{
-    ///Represents the range of coordinates on the alternate axis
-	interval inter;
-    ///Represents the fixed point on a certain axis
-	ll x;
-    ///Definition of comparator to facilitate set insertions in a sorted order
-    ///
-	bool operator<(const line_segment& e) const
-    { 
-        if(this->x<e.x)
-		{
-			return true;
-		}
-		else if(this->x==e.x)
-		{
-			if(this->inter.bottom<e.inter.bottom)
-			{
-				return true;
-			}
-			else if(this->inter.bottom==e.inter.bottom)
-			{
-				if(this->inter.top<e.inter.top)
-				{
-					return true;
-				}
-				else
-				{
-					return false;
-				}
-			}
-			else
-			{
-				return false;
-			}
-		}
-        else
+    ///Makes sure that every worker of a task pool with the given size owns a private sub-arena, so that workers can allocate without locking. Must not be called while nodes are being allocated
+    void reserve_workers(size_t count)
+    {
+        while(workers.size()+1 < count)
         {
-            return false;
+            workers.emplace_back(new ctree_arena());
+        }
+    }
+
+    ///Returns the arena that the given task pool worker allocates from. Worker 0, the thread that drives the pool, allocates from this arena itself
+    ctree_arena& local(size_t worker)
+    {
+        if(worker == 0 or worker > workers.size())
+        {
+            return *this;
+        }
+        return *workers[worker-1];
+    }
+
+    ///Number of nodes handed out since the last reset, including the worker sub-arenas
+    size_t node_count() const
+    {
+        size_t total = nodes;
+        for(size_t i=0;i<workers.size();i++)
+        {
+            total += workers[i]->node_count();
+        }
+        return total;
+    }
+
+    ///Number of bytes held in slabs, whether or not they are in use, including the worker sub-arenas
+    size_t byte_count() const
+    {
+        size_t total = slabs.size()*SLAB_NODES*sizeof(ctree<C>);
+        for(size_t i=0;i<workers.size();i++)
+        {
+            total += workers[i]->byte_count();
         }
+        return total;
     }
 
-}line_segment;
+private:
+    ///Contiguous blocks of uninitialised storage for SLAB_NODES nodes each
+    vector<ctree<C>*> slabs;
+    ///Index of the slab that nodes are currently taken from
+    size_t current;
+    ///Number of nodes taken from the current slab
+    size_t used;
+    ///Number of nodes handed out since the last reset
+    size_t nodes;
+    ///Private sub-arenas of task pool workers 1 and up
+    vector<unique_ptr<ctree_arena>> workers;
+};
 
-///Brief description of rectangle structure
+///Brief description of task group
 ///
-///This structure contains two intervals that can define a rectangle along with a unique ID
-typedef struct rectangle
-{
-    ///Interval data structure that contains the x-bounds of the rectangle 
-    interval x_int;
-    ///Interval data structure that contains the y-bounds of the rectangle
-    interval y_int;
-    ///Unique ID given in the order of input to identify each rectangle separately
-    ll id;
-    
-}rectangle;
+///Counts the tasks spawned into a task pool that a caller will wait for
+typedef struct task_group
+{
+    ///Number of spawned tasks that have not finished yet
+    atomic<size_t> pending{0};
+}task_group;
 
-///Brief description of edge structure
+///Brief description of task pool
 ///
-///This structure contains an integer that defines a fixed point, an interval between which it spans, an edge type, and the unique ID representing the rectangle to which it belongs
-typedef struct edge
+///A fixed set of worker threads for fork-join parallelism. Every worker owns a deque of tasks: it pushes and pops its own tasks at the back and, when its deque is empty, steals the oldest task from the front of another deque.
+///Worker 0 is the thread driving the pool, whichever thread that is, and it only runs tasks while it waits on a task group; since worker 0 has a single deque and sub-arena, at most one outside thread may drive a pool at a time. Waiting threads keep running tasks, so nested spawns never block a worker
+class task_pool
 {
-    ///The type of the edge - either TOP, BOTTOM, LEFT or RIGHT
-    string edgetype;
-    ///The interval defines the length of the edge, and the minimum and maximum values that the variable coordinate can take
-    interval i;
-    ///The fixed coordinate of the edge
-    ll x;
-    ///Unique ID that was given to the rectangle containing this edge
-    ll rect_id;
-    ///Definition of comparator to facilitate set insertions in a sorted order
-    ///
-    bool operator<(const edge& e) const
-    { 
-        if(this->x < e.x)
+public:
+    ///Starts threads-1 background workers; a pool of size 1 runs every task on the waiting thread
+    explicit task_pool(size_t threads) : queues(max<size_t>(threads,1)), queued(0), stop(false)
+    {
+        for(size_t i=1;i<queues.size();i++)
         {
-            return true;
+            threads_.emplace_back(&task_pool::worker_loop, this, i);
+        }
+    }
+    task_pool(const task_pool&) = delete;
+    task_pool& operator=(const task_pool&) = delete;
+    ~task_pool()
+    {
+        {
+            lock_guard<mutex> lock(sleep_mutex);
+            stop = true;
         }
-        else if(this->x == e.x)
+        sleep_cv.notify_all();
+        for(size_t i=0;i<threads_.size();i++)
         {
-        
-            if(this->edgetype == "LEFT" and e.edgetype == "RIGHT")
+            threads_[i].join();
+        }
+    }
+
+    ///Number of workers, including the thread that drives the pool
+    size_t size() const
+    {
+        return queues.size();
+    }
+
+    ///Index of this pool's worker running the calling thread; 0 for any thread that is not one of its background workers, including the workers of other pools
+    size_t current_worker() const
+    {
+        const worker_id& id = worker_slot();
+        return id.pool == this ? id.index : 0;
+    }
+
+    ///Queues f on the calling worker's deque and adds it to the group g
+    void spawn(task_group& g, function<void()> f)
+    {
+        g.pending++;
+        queue_slot& q = queues[current_worker() < queues.size() ? current_worker() : 0];
+        {
+            lock_guard<mutex> lock(q.m);
+            q.tasks.push_back({std::move(f), &g});
+        }
+        queued++;
+        sleep_cv.notify_one();
+    }
+
+    ///Runs queued tasks until every task of the group g has finished
+    void wait(task_group& g)
+    {
+        while(g.pending.load() != 0)
+        {
+            if(!run_one(current_worker()))
             {
-                return true;
+                this_thread::yield();
             }
-            else if(this->edgetype == "RIGHT" and e.edgetype == "LEFT")
+        }
+    }
+
+private:
+    ///A task and the group that waits for it
+    typedef struct task
+    {
+        function<void()> f;
+        task_group* group;
+    }task;
+
+    ///The deque of one worker, guarded by its own lock
+    typedef struct queue_slot
+    {
+        mutex m;
+        deque<task> tasks;
+    }queue_slot;
+
+    ///The pool and index of the background worker a thread is, if any
+    typedef struct worker_id
+    {
+        const task_pool* pool;
+        size_t index;
+    }worker_id;
+
+    static worker_id& worker_slot()
+    {
+        static thread_local worker_id id = {NULL, 0};
+        return id;
+    }
+
+    ///Pops a task of worker self, or steals one from another worker, and runs it. Returns false when every deque was empty
+    bool run_one(size_t self)
+    {
+        if(self >= queues.size())
+        {
+            self = 0;
+        }
+        task t;
+        bool found = false;
+        {
+            queue_slot& q = queues[self];
+            lock_guard<mutex> lock(q.m);
+            if(!q.tasks.empty())
             {
-                return false;
+                t = std::move(q.tasks.back());
+                q.tasks.pop_back();
+                found = true;
             }
-            else
+        }
+        for(size_t k=1;k<queues.size() and !found;k++)
+        {
+            queue_slot& q = queues[(self+k)%queues.size()];
+            lock_guard<mutex> lock(q.m);
+            if(!q.tasks.empty())
             {
-                if(this->i.bottom < e.i.bottom)
-                {
-                    return true;
-                }
-                else if(this->i.bottom == e.i.bottom)
-                {
-                    if(this->i.top < e.i.top)
-                    {
-                        return true;
-                    }
-                    else
-                    {
-                        return false;
-                    }
-                }
-                else
-                {
-                    return false;
-                }
+                t = std::move(q.tasks.front());
+                q.tasks.pop_front();
+                found = true;
             }
-        } 
-        else
+        }
+        if(!found)
         {
             return false;
         }
+        queued--;
+        t.f();
+        t.group->pending--;
+        return true;
     }
-}edge;
 
-///Brief description of ctree structure
+    void worker_loop(size_t self)
+    {
+        worker_slot() = {this, self};
+        while(true)
+        {
+            if(run_one(self))
+            {
+                continue;
+            }
+            unique_lock<mutex> lock(sleep_mutex);
+            if(stop)
+            {
+                return;
+            }
+            sleep_cv.wait_for(lock, chrono::milliseconds(1), [this]() { return stop or queued.load() != 0; });
+        }
+    }
+
+    ///One deque per worker
+    vector<queue_slot> queues;
+    ///Background worker threads, workers 1 and up
+    vector<thread> threads_;
+    ///Number of tasks sitting in any deque
+    atomic<size_t> queued;
+    ///Set when the pool shuts down
+    bool stop;
+    mutex sleep_mutex;
+    condition_variable sleep_cv;
+};
+
+///Brief description of parallel run
 ///
-///Used to represent the x union datatype present in stripes data structure. Used to store a range of intervals in the form of a binary search tree
-typedef struct ctree
+///The cutoffs of parallel_options together with the task pool that the parallel phases run on. Only a contour engine owns a pool, and only the thread computing on that engine drives it, so worker 0 and the sub-arena of worker 0 belong to that thread alone
+typedef struct parallel_run : parallel_options
 {
-    ///Represents the value of the node in the tree, used to decide whether to move to the left or the right of the tree during inorder traversal
-    ll x;
-    ///The type of the edge - either TOP, BOTTOM, LEFT or RIGHT
-    string lru;
-    ///The tree representing the left subtree of this node x
-    ctree* lson;
-    ///The tree representing the right subtree of this node x
-    ctree* rson;
-    ///Parameterized constructor to intiialize the values of the tree
-    ctree(ll x, string lru, ctree* lson, ctree* rson)
+    ///Task pool of the engine, or NULL to run everything on the calling thread
+    task_pool* pool = NULL;
+
+    explicit parallel_run(const parallel_options& options = parallel_options(), task_pool* pool = NULL) : parallel_options(options), pool(pool) {}
+}parallel_run;
+
+/*! Runs body over chunks of the index range [0, n), spreading the chunks over the pool when the range is large enough
+    \param pool the task pool to run on, or NULL to run sequentially
+    \param n size of the index range
+    \param min_chunk smallest number of indices worth handing to a separate task
+    \param body callable taking the bounds first and last of one chunk
+*/
+template<class F> void parallel_for(task_pool* pool, size_t n, size_t min_chunk, F body)
+{
+    min_chunk = max<size_t>(min_chunk,1);
+    if(pool == NULL or pool->size() == 1 or n < 2*min_chunk)
     {
-        this->x=x;
-        this->lru=lru;
-        this->lson=lson;
-        this->rson=rson;
+        body(size_t(0), n);
+        return;
+    }
+    size_t chunks = min(4*pool->size(), n/min_chunk);
+    task_group g;
+    for(size_t c=1;c<chunks;c++)
+    {
+        size_t first = n*c/chunks;
+        size_t last = n*(c+1)/chunks;
+        pool->spawn(g, [=]() { body(first, last); });
     }
-}ctree;
+    body(size_t(0), n/chunks);
+    pool->wait(g);
+}
 
 
 ///Brief description of stripe structure
 ///
 ///This structure is used to represent all horizontal stripes that the frame is partitioned into.
-typedef struct stripe
+template<class C> struct stripe
 {
     ///The interval x_int indicates the coordinates it spans from in the X direction
-    interval x_int;
+    basic_interval<C> x_int;
     ///The interval y_int indicates the coordinates it spans from in the Y direction
-    interval y_int;
+    basic_interval<C> y_int;
     ///Represents the binary search tree containing the x union information for this stripe
-    ctree* tree;
+    ctree<C>* tree;
     ///Definition of comparator to facilitate set insertions in a sorted order
     ///
     bool operator<(const stripe& e) const
@@ -228,144 +458,577 @@ typedef struct stripe
             return false;
         }
     }
-}stripe;
+};
+static_assert(sizeof(stripe<int32_t>) <= 24, "32 bit stripes must fit in 24 bytes");
 
 ///Global variable to store the possible values of edge types
-string EDGE_TYPES[4] = {"TOP","BOTTOM","LEFT","RIGHT"};
+const edge_tag EDGE_TYPES[4] = {TOP,BOTTOM,LEFT,RIGHT};
 
 ///Global variable to store the subtree type
-string LRU_TYPES[3] = {"LEFT","RIGHT","UNDEF"};
+const edge_tag LRU_TYPES[3] = {LEFT,RIGHT,UNDEF};
 
-///Global variable to store the rectangles input by the user
-vector<rectangle> iso_rectangles_input;
+///Global variable to store the printable name of every edge tag, indexed by the tag
+const char* EDGE_TAG_NAMES[5] = {"TOP","BOTTOM","LEFT","RIGHT","UNDEF"};
+
+///Brief description of interval_set
+///
+///A set of intervals, each paired with the ID of the rectangle whose edge created it, stored as one contiguous array sorted by interval and then by ID without duplicates.
+///Intersection, difference and union of two such sets are single linear merges
+template<class C> using interval_set = vector<pair<basic_interval<C>,int32_t>>;
 
 ///Brief description of StripeReturnType
 ///
 ///This structure encompasses all the returned components from the stripes algorithm
-typedef struct StripeReturnType
+template<class C> struct StripeReturnType
 {
     ///contains the set of intervals on the left side of the median, along with the ID number of the edge that created the interval
-    set<pair<interval,ll>> L;
+    interval_set<C> L;
     ///contains the set of intervals on the right side of the median, along with the ID number of the edge that created the interval
-    set<pair<interval,ll>> R;
-    ///contains the set of all points needed for partitioning
-    set<ll> P;
-    ///contains the set of stripes for the whole interval
-    set<stripe> S;
-}SRT;
+    interval_set<C> R;
+    ///contains the sorted, duplicate free coordinates needed for partitioning
+    vector<C> P;
+    ///contains the stripes for the whole interval, sorted from bottom to top
+    vector<stripe<C>> S;
+};
+template<class C> using SRT = StripeReturnType<C>;
 
-/// \fn findFrame
-///    Function that helps find the bounding frame around a set of iso-rectangles
-///    \brief Finds bounding frame around set of rectangles
-///    \return returns a rectangle structure containing information about the boundaries of the frame
+///Brief description of statistics timers
 ///
-rectangle findFrame()
+///Phases whose wall time the statistics report accumulates
+enum stats_timer
 {
-    rectangle frame;
-    ll minY=INT_MAX;
-    ll minX=INT_MAX;
-    ll maxY = INT_MIN;
-    ll maxX = INT_MIN;
-    for(ll i=0;i<iso_rectangles_input.size();i++)
+    T_FIND_FRAME,
+    T_RECTANGLE_DAC,
+    T_CONTOUR,
+    T_SWEEP_CONTOUR,
+    T_MERGE_INTERVALS,
+    T_PAIR_VERTICAL,
+    T_CSV_WRITER,
+    T_OUTPUT,
+    T_MEASURE,
+    T_POLYGONS,
+    T_RANK_COORDINATES,
+    T_COUNT
+};
+
+///Brief description of statistics counters
+///
+///Quantities that the statistics report accumulates
+enum stats_counter
+{
+    C_STRIPES_CREATED,
+    C_CTREE_NODES,
+    C_PIECES_UNMERGED,
+    C_PIECES_MERGED,
+    C_VERTICAL_SEGMENTS,
+    C_COUNT
+};
+
+///Brief description of memory kinds
+///
+///Containers of the divide and conquer whose live bytes the memory trace follows
+enum memory_kind
+{
+    M_STRIPES,
+    M_CTREE,
+    M_L,
+    M_R,
+    M_P,
+    M_COUNT
+};
+
+///Deepest level of the stripes recursion that gets its own row in the statistics report; deeper calls are folded into the last row
+const int STATS_MAX_DEPTH = 64;
+
+///Calls of stripes this deep or deeper get no row in the memory timeline, which would otherwise hold one row per edge; they still count towards the peaks of their depth
+const int MEMORY_TRACE_DEPTH = 16;
+
+#ifdef CONTOURS_STATS
+///Brief description of statistics registry
+///
+///Process wide totals behind the opt-in statistics report. Compiled in only with CONTOURS_STATS, and even then nothing is recorded until enabled is set, so a disabled build pays one predictable branch per probe.
+///All totals are atomic because the parallel phases record from several threads at once
+typedef struct stats_registry
+{
+    ///Set at run time to start recording
+    bool enabled = false;
+    ///Report as JSON instead of text
+    bool json = false;
+    ///Nanoseconds spent in, and number of entries into, every timed phase
+    atomic<ll> timer_ns[T_COUNT] = {};
+    atomic<ll> timer_calls[T_COUNT] = {};
+    ///Totals of every counter
+    atomic<ll> counters[C_COUNT] = {};
+    ///Per recursion depth of stripes: calls, nanoseconds spent outside the recursive calls, stripes produced and sizes of the returned L, R and P
+    atomic<ll> level_calls[STATS_MAX_DEPTH] = {};
+    atomic<ll> level_ns[STATS_MAX_DEPTH] = {};
+    atomic<ll> level_stripes[STATS_MAX_DEPTH] = {};
+    atomic<ll> level_L[STATS_MAX_DEPTH] = {};
+    atomic<ll> level_R[STATS_MAX_DEPTH] = {};
+    atomic<ll> level_P[STATS_MAX_DEPTH] = {};
+    ///Set at run time to follow the live bytes of the divide and conquer
+    bool memory = false;
+    ///Live bytes of every kind of container
+    atomic<ll> live[M_COUNT] = {};
+    ///Per recursion depth of stripes: highest live bytes of every kind, and in total at index M_COUNT, seen when a call of that depth finished
+    atomic<ll> level_peak[STATS_MAX_DEPTH][M_COUNT+1] = {};
+    ///File receiving the memory timeline at exit, and the rows collected for it: seconds since the trace started, depth and live bytes of every kind
+    string timeline_path;
+    mutex timeline_lock;
+    chrono::steady_clock::time_point timeline_start;
+    vector<array<ll,M_COUNT+2>> timeline;
+}stats_registry;
+
+///Global variable to store the statistics of this process
+stats_registry STATS;
+
+///Brief description of scoped timer
+///
+///Adds the time between its construction and destruction to one timer of the statistics registry, when recording is enabled
+class scoped_timer
+{
+public:
+    explicit scoped_timer(stats_timer t) : t(t), on(STATS.enabled)
     {
-        rectangle r = iso_rectangles_input[i];
-        if(r.x_int.bottom <= minX)
+        if(on)
         {
-            minX = r.x_int.bottom ;
+            start = chrono::steady_clock::now();
         }
-        if(r.x_int.top >= maxX)
-        {
-            maxX = r.x_int.top;
-        }
-        if(r.y_int.top >= maxY)
-        {
-            maxY = r.y_int.top;
-        }
-        if(r.y_int.bottom <= minY)
+    }
+    ~scoped_timer()
+    {
+        if(on)
         {
-            minY = r.y_int.bottom;
+            STATS.timer_ns[t] += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now()-start).count();
+            STATS.timer_calls[t]++;
         }
     }
-    interval x_bound;
-    interval y_bound;
-    x_bound.bottom = minX-2; x_bound.top = maxX+2;
-    y_bound.bottom = minY-2; y_bound.top = maxY+2;
-    frame.x_int = x_bound; frame.y_int = y_bound;
-    return frame;
+private:
+    stats_timer t;
+    bool on;
+    chrono::steady_clock::time_point start;
+};
+
+/*! Records one call of stripes at the given depth
+    \param depth recursion depth of the call, 0 for the outermost one
+    \param ns nanoseconds the call spent outside its recursive calls
+    \param srt the result of the call
+*/
+template<class C> void stats_level(int depth, ll ns, const SRT<C>& srt)
+{
+    int d = min(depth, STATS_MAX_DEPTH-1);
+    STATS.level_calls[d]++;
+    STATS.level_ns[d] += ns;
+    STATS.level_stripes[d] += srt.S.size();
+    STATS.level_L[d] += srt.L.size();
+    STATS.level_R[d] += srt.R.size();
+    STATS.level_P[d] += srt.P.size();
+    STATS.counters[C_STRIPES_CREATED] += srt.S.size();
 }
 
-/*! Creates continuous intervals for a given set of points along Y axis
-    \param y_coordinates a set of integers representing the coordinate points for partitioning
-    \return Set of intervals representing the partition induced by y coordinates 
-*/  
-set<interval> y_partition(set<ll> y_coordinates)
+/*! Adds the bytes held by a set of stripes to the live bytes of the memory trace, or takes them away
+    \param S the stripes
+    \param sign 1 when the stripes come to life, -1 when they are freed
+*/
+template<class C> void memory_add(const vector<stripe<C>>& S, ll sign)
 {
-    priority_queue <ll, vector<ll>, greater<ll>> partition_maker;
-    set<interval> plane_partitions;
-    set<ll>::iterator it = y_coordinates.begin();
-    while(it != y_coordinates.end())
-    {
-        partition_maker.push(*it);
-        ++it;
-    }
-    interval inter;
-    ll prev = partition_maker.top();
-    partition_maker.pop();
-    while(!partition_maker.empty())
+    STATS.live[M_STRIPES] += sign*ll(S.capacity()*sizeof(stripe<C>));
+}
+
+/*! Adds the bytes held by the result of a call of stripes to the live bytes of the memory trace, or takes them away
+    \param srt the result
+    \param sign 1 when the result comes to life, -1 when it is freed
+*/
+template<class C> void memory_add(const SRT<C>& srt, ll sign)
+{
+    memory_add(srt.S, sign);
+    STATS.live[M_L] += sign*ll(srt.L.capacity()*sizeof(srt.L[0]));
+    STATS.live[M_R] += sign*ll(srt.R.capacity()*sizeof(srt.R[0]));
+    STATS.live[M_P] += sign*ll(srt.P.capacity()*sizeof(C));
+}
+
+/*! Raises an atomic maximum
+    \param peak the maximum
+    \param value the value it must not be below
+*/
+void memory_raise(atomic<ll>& peak, ll value)
+{
+    ll seen = peak.load();
+    while(seen < value and not peak.compare_exchange_weak(seen, value))
     {
-        inter.bottom = prev;
-        inter.top = partition_maker.top();
-        prev = partition_maker.top();
-        plane_partitions.insert(inter);
-        partition_maker.pop();
     }
-    return plane_partitions;
 }
-/*! Creates continuous intervals for a given set of points along Y axis
-    \return Set of integers representing the unique y coordinates of vertices of the input iso rectangles
+
+/*! Records the live bytes at the end of a call of stripes, in the peaks of its depth and, unless it is too deep, in the timeline
+    \param depth recursion depth of the call
 */
-set<ll> y_set()
+void memory_sample(int depth)
 {
-    set<ll> y_coordinates;
-    for(ll i=0;i<iso_rectangles_input.size();i++)
+    array<ll,M_COUNT+2> row;
+    row[1] = depth;
+    ll total = 0;
+    for(int k=0;k<M_COUNT;k++)
     {
-        y_coordinates.insert(iso_rectangles_input[i].y_int.bottom);
-        y_coordinates.insert(iso_rectangles_input[i].y_int.top);
+        row[k+2] = STATS.live[k];
+        total += row[k+2];
+    }
+    int d = min(depth, STATS_MAX_DEPTH-1);
+    for(int k=0;k<M_COUNT;k++)
+    {
+        memory_raise(STATS.level_peak[d][k], row[k+2]);
+    }
+    memory_raise(STATS.level_peak[d][M_COUNT], total);
+    if(depth < MEMORY_TRACE_DEPTH and not STATS.timeline_path.empty())
+    {
+        lock_guard<mutex> hold(STATS.timeline_lock);
+        row[0] = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now()-STATS.timeline_start).count();
+        STATS.timeline.push_back(row);
     }
-    return y_coordinates;
 }
 
-/*! Prints the inorder traversal of a binary search tree whose root is passed as the parameter
-    \param node The root node of the tree of type ctree
+/*! Traces a call of stripes on a single edge: its result comes to life, along with the tree node it may have made
+    \param depth recursion depth of the call
+    \param srt the result of the call
 */
-void inorder(ctree *node)
+template<class C> void memory_leaf(int depth, const SRT<C>& srt)
 {
-    if (node == NULL)
-        return;
-    if (node->lru == "LEFT" || node->lru == "RIGHT")
+    memory_add(srt, 1);
+    STATS.live[M_CTREE] += ll(count_if(srt.S.begin(), srt.S.end(), [](const stripe<C>& s) { return s.tree != NULL; })*sizeof(ctree<C>));
+    memory_sample(depth);
+}
+
+/*! Traces the merge of a call of stripes. It is sampled while the results of both halves, their copies on the common partition and the merged result are all alive, which is the peak of the call; afterwards only the merged result stays
+    \param depth recursion depth of the call
+    \param left result of the left half
+    \param right result of the right half
+    \param S_left stripes of the left half copied onto the common partition
+    \param S_right stripes of the right half copied onto the common partition
+    \param srt the merged result
+*/
+template<class C> void memory_merge(int depth, const SRT<C>& left, const SRT<C>& right, const vector<stripe<C>>& S_left, const vector<stripe<C>>& S_right, const SRT<C>& srt)
+{
+    ll joined = 0;
+    for(size_t k=0;k<S_left.size();k++)
     {
-        if (node->lru == "LEFT")
-            cout << "Left: ";
-        else
-            cout << "Right: ";
-        cout << " " << node->x << " ";
-        return;
+        joined += S_left[k].tree != NULL and S_right[k].tree != NULL;
     }
-    inorder(node->lson);
-    inorder(node->rson);
+    STATS.live[M_CTREE] += joined*ll(sizeof(ctree<C>));
+    memory_add(srt, 1);
+    memory_add(S_left, 1);
+    memory_add(S_right, 1);
+    memory_sample(depth);
+    memory_add(S_left, -1);
+    memory_add(S_right, -1);
+    memory_add(left, -1);
+    memory_add(right, -1);
 }
 
-/*! Creates a vector of pointers to trees containing the node whose values lie within the interval low_x and high_x
-    \param node The root node of the tree of type ctree which has to be searched
-    \param low_x Marks the lower limit of the interval to be searched
-    \param high_x Marks the higher limit of the interval to be searched
-    \param res A constantly updated vector of nodes of type ctree that are contained in the interval depicted by low_x and high_x
+/*! Ends the trace of one divide and conquer: its stripes and tree nodes leave the live bytes, so that the next computation starts from what the others still hold
+    \param srt the result of the outermost call of stripes
+    \param nodes tree nodes made by the divide and conquer
 */
-void inorder_find(ctree *node, ll low_x, ll high_x, vector<ctree *> &res)
+template<class C> void memory_done(const SRT<C>& srt, ll nodes)
+{
+    memory_add(srt, -1);
+    STATS.live[M_CTREE] -= nodes*ll(sizeof(ctree<C>));
+}
+
+///Global variable to store the report names of the memory kinds, indexed by memory_kind, followed by the name of their total
+const char* MEMORY_KIND_NAMES[M_COUNT+1] = {"stripes","ctree","L","R","P","total"};
+
+/*! Writes the memory timeline as CSV: one row per traced call of stripes, in the order the calls finished
+    \param path file receiving the timeline
+*/
+void memory_timeline_write(const string& path)
+{
+    ofstream out(path);
+    out << "seconds,depth";
+    for(int k=0;k<=M_COUNT;k++)
+    {
+        out << "," << MEMORY_KIND_NAMES[k];
+    }
+    out << "\n";
+    for(auto& row : STATS.timeline)
+    {
+        ll total = 0;
+        out << fixed << setprecision(6) << row[0]*1e-9 << "," << row[1];
+        for(int k=0;k<M_COUNT;k++)
+        {
+            out << "," << row[k+2];
+            total += row[k+2];
+        }
+        out << "," << total << "\n";
+    }
+    if(not out)
+    {
+        cerr << "could not write the memory timeline to " << path << "\n";
+    }
+}
+
+///Global variable to store the report names of the timers, indexed by stats_timer
+const char* STATS_TIMER_NAMES[T_COUNT] = {"findFrame","rectangle_DAC","contour","sweep_contour","merge_intervals","pair_vertical_contours","csv_writer","output","sweep_measures","assemble_polygons","rank_coordinates"};
+///Global variable to store the report names of the counters, indexed by stats_counter
+const char* STATS_COUNTER_NAMES[C_COUNT] = {"stripes_created","ctree_nodes","pieces_unmerged","pieces_merged","vertical_segments"};
+
+/*! Writes the statistics report, as text or as JSON depending on the registry
+    \param out stream receiving the report
+*/
+void stats_report(ostream& out)
+{
+    int depth = STATS_MAX_DEPTH;
+    while(depth > 0 and STATS.level_calls[depth-1] == 0)
+    {
+        depth--;
+    }
+    if(STATS.json)
+    {
+        out << "{\"timers\": {";
+        for(int t=0;t<T_COUNT;t++)
+        {
+            out << (t ? ", " : "") << "\"" << STATS_TIMER_NAMES[t] << "\": {\"seconds\": " << STATS.timer_ns[t]*1e-9 << ", \"calls\": " << STATS.timer_calls[t] << "}";
+        }
+        out << "}, \"counters\": {";
+        for(int c=0;c<C_COUNT;c++)
+        {
+            out << (c ? ", " : "") << "\"" << STATS_COUNTER_NAMES[c] << "\": " << STATS.counters[c];
+        }
+        out << "}, \"stripes_levels\": [";
+        for(int d=0;d<depth;d++)
+        {
+            out << (d ? ", " : "") << "{\"depth\": " << d << ", \"calls\": " << STATS.level_calls[d] << ", \"seconds\": " << STATS.level_ns[d]*1e-9;
+            out << ", \"stripes\": " << STATS.level_stripes[d] << ", \"L\": " << STATS.level_L[d] << ", \"R\": " << STATS.level_R[d] << ", \"P\": " << STATS.level_P[d] << "}";
+        }
+        out << "]";
+        if(STATS.memory)
+        {
+            out << ", \"memory_peaks\": [";
+            for(int d=0;d<depth;d++)
+            {
+                out << (d ? ", " : "") << "{\"depth\": " << d;
+                for(int k=0;k<=M_COUNT;k++)
+                {
+                    out << ", \"" << MEMORY_KIND_NAMES[k] << "\": " << STATS.level_peak[d][k];
+                }
+                out << "}";
+            }
+            out << "]";
+        }
+        out << "}\n";
+        return;
+    }
+    out << "Statistics\n  phase                      seconds     calls\n";
+    for(int t=0;t<T_COUNT;t++)
+    {
+        out << "  " << left << setw(24) << STATS_TIMER_NAMES[t] << right << setw(10) << fixed << setprecision(6) << STATS.timer_ns[t]*1e-9 << setw(10) << STATS.timer_calls[t] << "\n";
+    }
+    out << "  counter                      total\n";
+    for(int c=0;c<C_COUNT;c++)
+    {
+        out << "  " << left << setw(24) << STATS_COUNTER_NAMES[c] << right << setw(12) << STATS.counters[c] << "\n";
+    }
+    out << "  stripes depth    calls    seconds      stripes            L            R            P\n";
+    for(int d=0;d<depth;d++)
+    {
+        out << "  " << setw(13) << d << setw(9) << STATS.level_calls[d] << setw(11) << STATS.level_ns[d]*1e-9;
+        out << setw(13) << STATS.level_stripes[d] << setw(13) << STATS.level_L[d] << setw(13) << STATS.level_R[d] << setw(13) << STATS.level_P[d] << "\n";
+    }
+    if(STATS.memory)
+    {
+        out << "  peak bytes depth      stripes        ctree            L            R            P        total\n";
+        for(int d=0;d<depth;d++)
+        {
+            out << "  " << setw(16) << d;
+            for(int k=0;k<=M_COUNT;k++)
+            {
+                out << setw(13) << STATS.level_peak[d][k];
+            }
+            out << "\n";
+        }
+    }
+}
+
+#define STATS_TIMER(t) scoped_timer stats_timer_guard(t)
+#define STATS_COUNT(c,v) do { if(STATS.enabled) { STATS.counters[c] += (v); } } while(0)
+#define STATS_NOW() (STATS.enabled ? chrono::steady_clock::now() : chrono::steady_clock::time_point())
+#define STATS_LEVEL(depth,start,srt) do { if(STATS.enabled) { stats_level(depth, chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now()-(start)).count(), srt); } } while(0)
+#define STATS_MEMORY_LEAF(depth,srt) do { if(STATS.memory) { memory_leaf(depth, srt); } } while(0)
+#define STATS_MEMORY_MERGE(depth,left,right,S_left,S_right,srt) do { if(STATS.memory) { memory_merge(depth, left, right, S_left, S_right, srt); } } while(0)
+#define STATS_MEMORY_DONE(srt,nodes) do { if(STATS.memory) { memory_done(srt, nodes); } } while(0)
+#else
+#define STATS_TIMER(t) do {} while(0)
+#define STATS_COUNT(c,v) do { (void)sizeof(v); } while(0)
+#define STATS_NOW() 0
+#define STATS_LEVEL(depth,start,srt) do { (void)(start); } while(0)
+#define STATS_MEMORY_LEAF(depth,srt) do {} while(0)
+#define STATS_MEMORY_MERGE(depth,left,right,S_left,S_right,srt) do {} while(0)
+#define STATS_MEMORY_DONE(srt,nodes) do {} while(0)
+#endif
+
+bool stats_enable(bool json)
+{
+#ifdef CONTOURS_STATS
+    static bool registered = false;
+    STATS.enabled = true;
+    STATS.json = json;
+    if(not registered)
+    {
+        registered = true;
+        atexit([]() { stats_report(cerr); });
+    }
+    return true;
+#else
+    (void)json;
+    return false;
+#endif
+}
+
+bool stats_trace_memory(const string& path)
+{
+#ifdef CONTOURS_STATS
+    static bool registered = false;
+    STATS.memory = true;
+    STATS.timeline_path = path;
+    STATS.timeline_start = chrono::steady_clock::now();
+    if(not registered)
+    {
+        registered = true;
+        atexit([]() { memory_timeline_write(STATS.timeline_path); });
+    }
+    return true;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+/// \fn findFrame
+///    Function that helps find the bounding frame around a set of iso-rectangles
+///    \brief Finds bounding frame around set of rectangles
+///    \param rect first of the iso-rectangles
+///    \param n number of iso-rectangles
+///    \return returns a rectangle structure containing information about the boundaries of the frame
+///
+rectangle findFrame(const rectangle* rect, size_t n)
+{
+    STATS_TIMER(T_FIND_FRAME);
+    rectangle frame;
+    //seeded with the extremes of ll rather than of int, so coordinates beyond 32 bits bound the frame too; with no rectangles the frame comes out inverted, which any later minimum or maximum overrides
+    ll minY = numeric_limits<ll>::max();
+    ll minX = numeric_limits<ll>::max();
+    ll maxY = numeric_limits<ll>::min();
+    ll maxX = numeric_limits<ll>::min();
+    //without branches the compiler turns the four bounds into conditional moves or vector minima, so the scan runs at memory speed
+    for(size_t i=0;i<n;i++)
+    {
+        const rectangle& r = rect[i];
+        minX = min(minX, r.x_int.bottom);
+        maxX = max(maxX, r.x_int.top);
+        minY = min(minY, r.y_int.bottom);
+        maxY = max(maxY, r.y_int.top);
+    }
+    //the margin stops at the limits of ll, where it would wrap around and turn the frame inside out; a frame lying on the outermost coordinates still bounds them
+    auto below = [](ll v) { return v < numeric_limits<ll>::min()+2 ? numeric_limits<ll>::min() : v-2; };
+    auto above = [](ll v) { return v > numeric_limits<ll>::max()-2 ? numeric_limits<ll>::max() : v+2; };
+    interval x_bound;
+    interval y_bound;
+    x_bound.bottom = below(minX); x_bound.top = above(maxX);
+    y_bound.bottom = below(minY); y_bound.top = above(maxY);
+    frame.x_int = x_bound; frame.y_int = y_bound;
+    return frame;
+}
+
+/*! Tells whether a frame lies on a limit of ll, which happens when coordinates come within two units of the limits. The tiled and sharded modes grow their boxes one unit past the frame, so they turn such inputs down
+    \param frame the frame made by findFrame
+    \return true if a side of the frame lies on a limit of ll
+*/
+bool frame_at_limits(const rectangle& frame)
+{
+    return frame.x_int.bottom == numeric_limits<ll>::min() or frame.y_int.bottom == numeric_limits<ll>::min() or frame.x_int.top == numeric_limits<ll>::max() or frame.y_int.top == numeric_limits<ll>::max();
+}
+
+/*! Tells whether a computation may take n rectangles, reporting to the error stream when it may not
+    \param n number of rectangles
+    \param who name of the computation, starting the report
+    \return false if n exceeds MAX_RECTANGLES, beyond which the 32 bit rectangle IDs of the edges would wrap
+*/
+bool rectangles_fit(size_t n, const char* who)
+{
+    if(n > MAX_RECTANGLES)
+    {
+        cerr << who << ": more than " << MAX_RECTANGLES << " rectangles are not supported\n";
+        return false;
+    }
+    return true;
+}
+
+/*! Creates continuous intervals for a given set of points along Y axis
+    \param y_coordinates a sorted, duplicate free array representing the coordinate points for partitioning
+    \return Intervals representing the partition induced by y coordinates, from bottom to top
+*/  
+template<class C> vector<basic_interval<C>> y_partition(const vector<C>& y_coordinates)
+{
+    vector<basic_interval<C>> plane_partitions;
+    if(y_coordinates.size() < 2)
+    {
+        return plane_partitions;
+    }
+    plane_partitions.reserve(y_coordinates.size()-1);
+    basic_interval<C> inter;
+    for(size_t k=1;k<y_coordinates.size();k++)
+    {
+        inter.bottom = y_coordinates[k-1];
+        inter.top = y_coordinates[k];
+        plane_partitions.push_back(inter);
+    }
+    return plane_partitions;
+}
+/*! Creates continuous intervals for a given set of points along Y axis
+    \param rect first of the iso rectangles
+    \param n number of iso rectangles
+    \return Set of integers representing the unique y coordinates of vertices of the input iso rectangles
+*/
+set<ll> y_set(const rectangle* rect, size_t n)
+{
+    set<ll> y_coordinates;
+    for(size_t i=0;i<n;i++)
+    {
+        y_coordinates.insert(rect[i].y_int.bottom);
+        y_coordinates.insert(rect[i].y_int.top);
+    }
+    return y_coordinates;
+}
+
+/*! Prints the inorder traversal of a binary search tree whose root is passed as the parameter
+    \param node The root node of the tree of type ctree
+*/
+template<class C> void inorder(ctree<C> *node)
+{
+    if (node == NULL)
+        return;
+    if (node->lru == LEFT || node->lru == RIGHT)
+    {
+        if (node->lru == LEFT)
+            cout << "Left: ";
+        else
+            cout << "Right: ";
+        cout << " " << node->x << " ";
+        return;
+    }
+    inorder(node->lson);
+    inorder(node->rson);
+}
+
+/*! Creates a vector of pointers to trees containing the node whose values lie within the interval low_x and high_x
+    \param node The root node of the tree of type ctree which has to be searched
+    \param low_x Marks the lower limit of the interval to be searched
+    \param high_x Marks the higher limit of the interval to be searched
+    \param res A constantly updated vector of nodes of type ctree that are contained in the interval depicted by low_x and high_x
+*/
+template<class C> void inorder_find(ctree<C> *node, C low_x, C high_x, vector<ctree<C> *> &res)
 {
     if (node == NULL)
         return;
-    if (node->lru == "LEFT" || node->lru == "RIGHT")
+    if (node->lru == LEFT || node->lru == RIGHT)
     {
             res.push_back(node);
     }
@@ -377,19 +1040,20 @@ void inorder_find(ctree *node, ll low_x, ll high_x, vector<ctree *> &res)
 /*! Gets the intersection of two sets of intervals
     \param i1 defines a set of intervals, along with the rectangle ID associated with that interval
     \param i2 defines a set of intervals, along with the rectangle ID associated with that interval
-    \return A set of pair of intervals and unique IDs constituting the set intersection of i1 and i2
+    \param i3 receives the pairs of intervals and unique IDs constituting the set intersection of i1 and i2; its previous contents are discarded
 */
-set<pair<interval,ll>> set_intersection(set<pair<interval,ll>> i1, set<pair<interval,ll>> i2)
+template<class C> void set_intersection(const interval_set<C>& i1, const interval_set<C>& i2, interval_set<C>& i3)
 {
     auto ite = i1.begin();
     auto itr = i2.begin();
-    set<pair<interval,ll>> i3;
+    i3.clear();
+    i3.reserve(min(i1.size(),i2.size()));
     while(ite!=i1.end() and itr!=i2.end())
     {
-        interval a = (*ite).first;
-        interval b = (*itr).first;
-        ll a_id = (*ite).second;
-        ll b_id = (*itr).second;
+        basic_interval<C> a = (*ite).first;
+        basic_interval<C> b = (*itr).first;
+        int32_t a_id = (*ite).second;
+        int32_t b_id = (*itr).second;
         if(a.bottom < b.bottom)
         {
             ite++;
@@ -398,7 +1062,7 @@ set<pair<interval,ll>> set_intersection(set<pair<interval,ll>> i1, set<pair<inte
         {
             if(a.top == b.top and a_id == b_id)
             {
-                i3.insert({a,a_id}); 
+                i3.push_back({a,a_id}); 
                 ite++;
                 itr++;
             }
@@ -427,27 +1091,27 @@ set<pair<interval,ll>> set_intersection(set<pair<interval,ll>> i1, set<pair<inte
             itr++;
         }
     }
-    return i3;
 }
 /*! Gets the difference of two sets of intervals
     \param i1 defines a set of intervals, along with the rectangle ID associated with that interval
     \param i2 defines a set of intervals, along with the rectangle ID associated with that interval
-    \return A set of pair of intervals and unique IDs constituting the set difference of i1 and i2
+    \param i3 receives the pairs of intervals and unique IDs constituting the set difference of i1 and i2; its previous contents are discarded
 */
-set<pair<interval,ll>> set_difference(set<pair<interval,ll>> i1,set<pair<interval,ll>> i2)
+template<class C> void set_difference(const interval_set<C>& i1, const interval_set<C>& i2, interval_set<C>& i3)
 {
     auto ite = i1.begin();
     auto itr = i2.begin();
-    set<pair<interval,ll>> i3;
+    i3.clear();
+    i3.reserve(i1.size());
     while(ite!=i1.end() and itr!=i2.end())
     {
-        interval a = (*ite).first;
-        interval b = (*itr).first;
-        ll a_id = (*ite).second;
-        ll b_id = (*itr).second;
+        basic_interval<C> a = (*ite).first;
+        basic_interval<C> b = (*itr).first;
+        int32_t a_id = (*ite).second;
+        int32_t b_id = (*itr).second;
         if(a.bottom < b.bottom)
         {
-            i3.insert({a,a_id}); 
+            i3.push_back({a,a_id}); 
             ite++;
         }
         else if(a.bottom == b.bottom)
@@ -461,7 +1125,7 @@ set<pair<interval,ll>> set_difference(set<pair<interval,ll>> i1,set<pair<interva
             {
                 if(a_id<b_id)
                 {
-                    i3.insert({a,a_id}); 
+                    i3.push_back({a,a_id}); 
                     ite++;
                 }
                 else
@@ -471,7 +1135,7 @@ set<pair<interval,ll>> set_difference(set<pair<interval,ll>> i1,set<pair<interva
             }
             else if(a.top < b.top)
             {
-                i3.insert({a,a_id});
+                i3.push_back({a,a_id});
                 ite++;
             }
             else
@@ -485,58 +1149,72 @@ set<pair<interval,ll>> set_difference(set<pair<interval,ll>> i1,set<pair<interva
         }
     }
 
-    while(ite != i1.end())
-    {
-        i3.insert((*ite));
-        ite++;
-    }
-
-    return i3;
+    i3.insert(i3.end(), ite, i1.end());
 }
 /*! Gets the union of two sets of intervals
     \param i1 defines a set of intervals, along with the rectangle ID associated with that interval
     \param i2 defines a set of intervals, along with the rectangle ID associated with that interval
-    \return A set of pair of intervals and unique IDs constituting the set union of i1 and i2
+    \param i3 receives the pairs of intervals and unique IDs constituting the set union of i1 and i2; its previous contents are discarded
 */
-set<pair<interval,ll>> set_union(set<pair<interval,ll>> i1,set<pair<interval,ll>> i2)
+template<class C> void set_union(const interval_set<C>& i1, const interval_set<C>& i2, interval_set<C>& i3)
 {
-    set<pair<interval,ll>> i3;
     auto ite = i1.begin();
     auto itr = i2.begin();
-    while(ite != i1.end())
-    {
-        i3.insert(*ite);
-        ++ite;
-    }
-    while(itr != i2.end())
+    i3.clear();
+    i3.reserve(i1.size()+i2.size());
+    while(ite != i1.end() and itr != i2.end())
     {
-        i3.insert(*itr);
-        ++itr;
+        if(*ite < *itr)
+        {
+            i3.push_back(*ite);
+            ++ite;
+        }
+        else if(*itr < *ite)
+        {
+            i3.push_back(*itr);
+            ++itr;
+        }
+        else
+        {
+            i3.push_back(*ite);
+            ++ite;
+            ++itr;
+        }
     }
-    return i3;
+    i3.insert(i3.end(), ite, i1.end());
+    i3.insert(i3.end(), itr, i2.end());
 }
-/*! Adds additional stripes to the existing set of stripes S based on the intervals induced by partition of P
-    \param S defines a set of existing stripes
-    \param P defines a set of partition points
+/*! Fills the stripes first to last-1 of the partition of P, each carrying the x union of the stripe of S that contains it
+    \param S defines the existing stripes, sorted from bottom to top
+    \param P defines the sorted partition points
     \param x_ext depicts the width of the stripe
-    \return Updated set of stripes containing the additional stripes induced by partition of P
+    \param s1 receives the stripes; must already hold one slot per interval of the partition
+    \param first index of the first partition interval to fill
+    \param last index one past the last partition interval to fill
 */
-set<stripe> copy(set<stripe> S, set<ll> P, interval x_ext)
+template<class C> void copy_range(const vector<stripe<C>>& S, const vector<C>& P, basic_interval<C> x_ext, vector<stripe<C>>& s1, size_t first, size_t last)
 {
-    set<interval> part = y_partition(P);
-    auto ite = part.begin();
-    auto itr = S.begin();
-    set<stripe> s1;
-    while(ite != part.end())
+    if(first >= last)
+    {
+        return;
+    }
+    //start at the last stripe of S lying at or below the first interval, the scan below moves up from there
+    auto itr = upper_bound(S.begin(), S.end(), P[first], [](C y, const stripe<C>& t) { return y < t.y_int.bottom; });
+    if(itr != S.begin())
+    {
+        --itr;
+    }
+    for(size_t k=first;k<last;k++)
     {
-        stripe stemp;
+        stripe<C> stemp;
         stemp.x_int = x_ext;
-        stemp.y_int = (*ite);
+        stemp.y_int.bottom = P[k];
+        stemp.y_int.top = P[k+1];
         stemp.tree = NULL;
         
         while(itr!= S.end())
         {
-            interval c = (*itr).y_int; //S
+            basic_interval<C> c = (*itr).y_int; //S
             if(stemp.y_int.bottom >= c.bottom)
             {
                 if(stemp.y_int.top <= c.top)
@@ -556,31 +1234,39 @@ set<stripe> copy(set<stripe> S, set<ll> P, interval x_ext)
             }
         }
 
-        s1.insert(stemp);
-        ++ite;
+        s1[k] = stemp;
     }
-
+}
+/*! Adds additional stripes to the existing set of stripes S based on the intervals induced by partition of P
+    \param S defines the existing stripes, sorted from bottom to top
+    \param P defines the sorted partition points
+    \param x_ext depicts the width of the stripe
+    \param par selects whether large partitions are filled in parallel
+    \return Stripes induced by the partition of P, each carrying the x union of the stripe of S that contains it
+*/
+template<class C> vector<stripe<C>> copy(const vector<stripe<C>>& S, const vector<C>& P, basic_interval<C> x_ext, const parallel_run& par)
+{
+    vector<stripe<C>> s1(P.size() < 2 ? 0 : P.size()-1);
+    parallel_for(par.pool, s1.size(), par.merge_cutoff, [&](size_t first, size_t last) { copy_range(S, P, x_ext, s1, first, last); });
     return s1;
-
 }
-/*! Updates the x_union values for the stripes that have not found a partner edge in S
-    \param S defines a set of existing stripes
+/*! Clears the x_union values of the stripes first to last-1 of S that are covered by an interval of J
+    \param S defines the stripes to update in place, sorted from bottom to top
     \param J defines the set of intervals which do not have a matching edge in S
-    \return Modified set of stripes with updated x_union values
+    \param first index of the first stripe to update
+    \param last index one past the last stripe to update
 */
-set<stripe> blacken(set<stripe> S, set<pair<interval,ll>> J)
+template<class C> void blacken_range(vector<stripe<C>>& S, const interval_set<C>& J, size_t first, size_t last)
 {
-    auto itr = S.begin();
+    //the scan only ever skips intervals ending below the current stripe, so every chunk may start from the beginning of J
     auto ite = J.begin();
-    set<stripe> s_final;
-    while(itr != S.end())
+    for(size_t k=first;k<last;k++)
     {
-        stripe stemp = (*itr);
-        interval i1 = stemp.y_int;
+        basic_interval<C> i1 = S[k].y_int;
         while(ite != J.end())
         {
             //i1 should be subset of i2
-            interval i2 = (*ite).first;
+            basic_interval<C> i2 = (*ite).first;
             if(i1.bottom < i2.bottom)
             {
                 break;
@@ -589,7 +1275,7 @@ set<stripe> blacken(set<stripe> S, set<pair<interval,ll>> J)
             {
                 if(i1.top <= i2.top)
                 {
-                    stemp.tree=NULL;
+                    S[k].tree=NULL;
                     break;
                 }
                 else
@@ -598,40 +1284,43 @@ set<stripe> blacken(set<stripe> S, set<pair<interval,ll>> J)
                 }
             }
         }
-        s_final.insert(stemp);
-        ++itr;
     }
-
-    return s_final;
 }
-/*! Combines stripes located across the median line
-    \param s_left defines a set of stripes on the left side of the median line
-    \param s_right defines a set of stripes on the right side of the median line
-    \param P defines a set of partition points
+/*! Clears the x_union values for the stripes that have not found a partner edge in S
+    \param S defines the stripes to update in place, sorted from bottom to top
+    \param J defines the set of intervals which do not have a matching edge in S
+    \param par selects whether large stripe sets are updated in parallel
+*/
+template<class C> void blacken(vector<stripe<C>>& S, const interval_set<C>& J, const parallel_run& par)
+{
+    parallel_for(par.pool, S.size(), par.merge_cutoff, [&](size_t first, size_t last) { blacken_range(S, J, first, last); });
+}
+/*! Combines the stripes first to last-1 located across the median line
+    \param s_left defines the stripes on the left side of the median line, one per interval of the partition of P
+    \param s_right defines the stripes on the right side of the median line, one per interval of the partition of P
     \param x_ext depicts the width of the stripe
-    \return Updated set of stripes formed using s_left and s_right after dissolving the median line 
+    \param arena owns the internal ctree nodes; each pool worker allocates from its own sub-arena
+    \param pool the task pool running this range, or NULL
+    \param S receives the combined stripes; must already hold one slot per interval of the partition
+    \param first index of the first stripe to combine
+    \param last index one past the last stripe to combine
 */
-set<stripe> concat(set<stripe> s_left, set<stripe> s_right, set<ll> P, interval x_ext)
+template<class C> void concat_range(const vector<stripe<C>>& s_left, const vector<stripe<C>>& s_right, basic_interval<C> x_ext, ctree_arena<C>& arena, const task_pool* pool, vector<stripe<C>>& S, size_t first, size_t last)
 {
-    set<interval> part = y_partition(P);
-    auto ite = part.begin();
-    auto itr1 = s_left.begin();
-    auto itr2 = s_right.begin();
-    set<stripe> S;
-
-    while(ite != part.end())
+    ctree_arena<C>& local = arena.local(pool ? pool->current_worker() : 0);
+    for(size_t k=first;k<last;k++)
     {
-        stripe stemp;
+        stripe<C> stemp;
         stemp.x_int = x_ext;
-        stemp.y_int = (*ite);
+        stemp.y_int = s_left[k].y_int;
         stemp.tree = NULL;
 
-        stripe val1 = (*itr1);
-        stripe val2 = (*itr2);
+        const stripe<C>& val1 = s_left[k];
+        const stripe<C>& val2 = s_right[k];
         
         if(val1.tree!=NULL and val2.tree!=NULL)  
         {
-            stemp.tree=new ctree(val1.x_int.top,"UNDEF",val1.tree, val2.tree);
+            stemp.tree=local.make(val1.x_int.top,UNDEF,val1.tree, val2.tree);
         }
         else if(val1.tree!=NULL and val2.tree==NULL)
         {
@@ -645,504 +1334,3887 @@ set<stripe> concat(set<stripe> s_left, set<stripe> s_right, set<ll> P, interval
         {
             stemp.tree=NULL;
         }
-        itr1++; 
-        itr2++;
-        S.insert(stemp);
-        ++ite;
+        S[k] = stemp;
     }
+}
+/*! Combines stripes located across the median line
+    \param s_left defines the stripes on the left side of the median line, one per interval of the partition of P
+    \param s_right defines the stripes on the right side of the median line, one per interval of the partition of P
+    \param x_ext depicts the width of the stripe
+    \param arena owns the internal ctree nodes created while joining the x unions of both halves
+    \param par selects whether large stripe sets are combined in parallel
+    \return Stripes formed using s_left and s_right after dissolving the median line, sorted from bottom to top
+*/
+template<class C> vector<stripe<C>> concat(const vector<stripe<C>>& s_left, const vector<stripe<C>>& s_right, basic_interval<C> x_ext, ctree_arena<C>& arena, const parallel_run& par)
+{
+    vector<stripe<C>> S(s_left.size());
+    parallel_for(par.pool, S.size(), par.merge_cutoff, [&](size_t first, size_t last) { concat_range(s_left, s_right, x_ext, arena, par.pool, S, first, last); });
     return S;
 }
 /*! Divde and conquer algorithm that computes the set of stripes along with their x_union values for the given set of vertical edges
-    \param VRX defines a set of stripes on the left side of the median line
+    \param VRX defines the vertical edges of all rectangles, sorted
+    \param lo index of the first edge of VRX handled by this call
+    \param hi index one past the last edge of VRX handled by this call
     \param x_ext depicts the width of the frame
     \param ylimits represents the height of the frame
+    \param arena owns every ctree node created for the x unions of the stripes; each pool worker allocates from its own sub-arena
+    \param par selects whether the two halves, and large merges, run in parallel
+    \param depth recursion depth of this call, 0 for the outermost one
     \return Intermediary results required for producing the result of the previous call (comprising of set of <interval,int> L, set of <interval,int> R, set of coordinates P and set of stripes S)
 */
-SRT stripes(set<edge> VRX, interval x_ext, interval ylimits)
+template<class C> SRT<C> stripes(const vector<basic_edge<C>>& VRX, size_t lo, size_t hi, basic_interval<C> x_ext, basic_interval<C> ylimits, ctree_arena<C>& arena, const parallel_run& par, int depth = 0)
 {
+    auto stats_start = STATS_NOW();
     
-    if(VRX.size()==1)
+    if(hi-lo==1)
     {
-        SRT temp1;
-        auto it = VRX.begin();
-        edge e = *it;
-        if(e.edgetype == "LEFT")
+        SRT<C> temp1;
+        const basic_edge<C>& e = VRX[lo];
+        if(e.edgetype == LEFT)
         {
-            interval l1 = e.i;
-            temp1.L.insert({l1,e.rect_id});
+            basic_interval<C> l1 = e.i;
+            temp1.L.push_back({l1,e.rect_id});
         }
         else
         {
-            interval r1 = e.i;
-            temp1.R.insert({r1,e.rect_id});    
+            basic_interval<C> r1 = e.i;
+            temp1.R.push_back({r1,e.rect_id});    
         }
 
-        temp1.P.insert(ylimits.bottom);
-        temp1.P.insert(e.i.bottom);
-        temp1.P.insert(e.i.top);
-        temp1.P.insert(ylimits.top);
+        temp1.P = {ylimits.bottom, e.i.bottom, e.i.top, ylimits.top};
+        sort(temp1.P.begin(), temp1.P.end());
+        temp1.P.erase(unique(temp1.P.begin(), temp1.P.end()), temp1.P.end());
 
-        set<interval> part = y_partition(temp1.P);
+        ctree_arena<C>& local = arena.local(par.pool ? par.pool->current_worker() : 0);
+        vector<basic_interval<C>> part = y_partition(temp1.P);
+        temp1.S.reserve(part.size());
         auto ite = part.begin();
         while(ite != part.end())
         {
-            stripe stemp;
+            stripe<C> stemp;
             stemp.x_int = x_ext;
             stemp.y_int = *ite;
-            stemp.tree =(ctree*)malloc(sizeof(ctree));
             stemp.tree=NULL;
             if((stemp.y_int.bottom == e.i.bottom) and (stemp.y_int.top == e.i.top))
             {
-                if(e.edgetype == "LEFT")
+                if(e.edgetype == LEFT)
                 {
-                    stemp.tree=new ctree(e.x,"LEFT",NULL,NULL);
+                    stemp.tree=local.make(e.x,LEFT,NULL,NULL);
                 }
-                else if(e.edgetype == "RIGHT")
+                else if(e.edgetype == RIGHT)
                 {
-                    stemp.tree=new ctree(e.x,"RIGHT",NULL,NULL);
+                    stemp.tree=local.make(e.x,RIGHT,NULL,NULL);
                 }
             }
-            temp1.S.insert(stemp);
+            temp1.S.push_back(stemp);
             ++ite;
         }
+        STATS_LEVEL(depth,stats_start,temp1);
+        STATS_MEMORY_LEAF(depth,temp1);
         return temp1;
     }
     else
     {
-        ll n = VRX.size();
-        ll xm;
-        set<edge> v1,v2;
-        auto it = VRX.begin();
-        for(ll i=0;i<n/2;i++)
-        {
-            v1.insert(*it);
-            ++it;
-        }
-        for(ll i=n/2;i<n;i++)
-        {
-            if(i==n/2)
-            {
-                xm = (*it).x;
-            }
-            
-            v2.insert(*it);
-            ++it;
-        }
-        SRT left,right;
-        interval left_call,right_call;
+        size_t mid = lo + (hi-lo)/2;
+        C xm = VRX[mid].x;
+        basic_interval<C> left_call,right_call;
         left_call.bottom = x_ext.bottom;
         left_call.top = xm;
         right_call.bottom = xm;
         right_call.top = x_ext.top;
 
-        left = stripes(v1, left_call,ylimits);
-        right = stripes(v2,right_call,ylimits);
-
-        
-        set<pair<interval,ll>> L1=left.L;
-        set<pair<interval,ll>> R2=right.R;
-        
-        set<pair<interval,ll>> L,R;
-        set<pair<interval,ll>> LR;
-        
-        LR = set_intersection(L1,R2);
-        set<pair<interval,ll>> l1lr = set_difference(L1,LR);
-        set<pair<interval,ll>> r2lr = set_difference(R2,LR);
-        L = set_union(right.L,l1lr);
-        R = set_union(left.R,r2lr);
-     
-      
-        set<ll> P;
-        set<ll> P1= left.P;
-        set<ll> P2= right.P;
-        auto itr=P1.begin();
-        while(itr!=P1.end())
-        {
-            P.insert(*itr);
-            itr++;
+        SRT<C> left,right;
+        if(par.pool != NULL and hi-lo > par.dac_cutoff)
+        {
+            task_group halves;
+            par.pool->spawn(halves, [&]() { left = stripes(VRX, lo, mid, left_call,ylimits,arena,par,depth+1); });
+            right = stripes(VRX, mid, hi, right_call,ylimits,arena,par,depth+1);
+            par.pool->wait(halves);
         }
-        itr=P2.begin();
-        while(itr!=P2.end())
+        else
         {
-            P.insert(*itr);
-            itr++;
+            left = stripes(VRX, lo, mid, left_call,ylimits,arena,par,depth+1);
+            right = stripes(VRX, mid, hi, right_call,ylimits,arena,par,depth+1);
         }
+        //only the merge below counts towards this level
+        stats_start = STATS_NOW();
 
+        
+        const interval_set<C>& L1=left.L;
+        const interval_set<C>& R2=right.R;
+        
+        interval_set<C> LR,l1lr,r2lr;
+        set_intersection(L1,R2,LR);
+        set_difference(L1,LR,l1lr);
+        set_difference(R2,LR,r2lr);
 
-        set<stripe> S_left,S_right;
-        interval slefttemp;
-        slefttemp.bottom=x_ext.bottom;
-        slefttemp.top=xm;
-        interval srighttemp;
-        srighttemp.bottom=xm;
-        srighttemp.top=x_ext.top;
-
-        S_left=copy(left.S,P,slefttemp);
-        S_right=copy(right.S,P,srighttemp);
+        SRT<C> temp2;
+        set_union(right.L,l1lr,temp2.L);
+        set_union(left.R,r2lr,temp2.R);
+     
+        temp2.P.reserve(left.P.size()+right.P.size());
+        std::set_union(left.P.begin(), left.P.end(), right.P.begin(), right.P.end(), back_inserter(temp2.P));
 
-        S_left = blacken(S_left,r2lr);
-        S_right = blacken(S_right,l1lr);
+        vector<stripe<C>> S_left = copy(left.S,temp2.P,left_call,par);
+        vector<stripe<C>> S_right = copy(right.S,temp2.P,right_call,par);
 
-        set<stripe> S;
-        S = concat(S_left, S_right, P, x_ext);
+        blacken(S_left,r2lr,par);
+        blacken(S_right,l1lr,par);
 
-        SRT temp2;
-        temp2.L = L;
-        temp2.R = R;
-        temp2.P = P;
-        temp2.S = S;
+        temp2.S = concat(S_left, S_right, x_ext, arena, par);
         
+        STATS_LEVEL(depth,stats_start,temp2);
+        STATS_MEMORY_MERGE(depth,left,right,S_left,S_right,temp2);
         return temp2;
     }
 }
-/*! Driver function used to call the divide and conquer algorithm stripes when provided with a set of iso-oriented rectangles
-    \param rect defines the collection of iso oriented rectangles input by the users
-    \return Final set of stripes computed by the stripes algorithm
+/*! Sorts edges and removes the ones comparing equal to an earlier edge, which leaves the same edges, in the same order, as inserting them into a set
+    \param edges the edges to sort in place
 */
-set<stripe> rectangle_DAC(vector<rectangle> rect)
+template<class C> void sort_edges(vector<basic_edge<C>>& edges)
 {
-    vector<rectangle>::iterator it = rect.begin();
-    set<edge> VRX;
-    while(it != rect.end())
-    {
-        edge e1;
-        e1.edgetype = "LEFT";
-        e1.i = (*it).y_int;
-        e1.x =  (*it).x_int.bottom;
-        // e1.rect=&(*it);
-        e1.rect_id = (*it).id;
-
-
-        edge e2;
-        e2.edgetype = "RIGHT";
-        e2.i = (*it).y_int;
-        e2.x =  (*it).x_int.top;
-        e2.rect_id = (*it).id;
-
-        VRX.insert(e1);
-        VRX.insert(e2);
-        it++;
-    }
-
-    set<interval> L,R;
-    set<ll> P;
-    interval ylimits;
-    rectangle frame = findFrame();
-    ylimits.bottom = frame.y_int.bottom;
-    ylimits.top = frame.y_int.top;
-    interval xlimits;
-    xlimits.bottom = frame.x_int.bottom;
-    xlimits.top = frame.x_int.top;
-    SRT srt;
-    srt = stripes(VRX,xlimits, ylimits);
-    return srt.S;
-    
+    stable_sort(edges.begin(), edges.end());
+    edges.erase(unique(edges.begin(), edges.end(), [](const basic_edge<C>& a, const basic_edge<C>& b) { return !(a < b) and !(b < a); }), edges.end());
 }
-/*! Fumction to compute the horizontal contours associated with the given edge and the set of stripes
-    \param h Horizontal edge which is part of an input rectangle
-    \param S defines the set of stripes that the frame is partitioned into
-    \return Set of line segments representing the horizontal contours associated with the current edge
+/*! Replaces the coordinates of the rectangles by their ranks and creates the edges of every rectangle in rank space
+    \param rect defines the collection of iso oriented rectangles input by the users
+    \param n number of rectangles, fewer than 2^30; the position of a rectangle serves as its unique ID
+    \param ranks receives the distinct coordinates of both axes
+    \param VRX receives the left and right edges of all rectangles in input order
+    \param HRX receives the bottom and top edges of all rectangles in input order, with the y rank stored as the fixed coordinate
+    \param par selects the task pool that ranks the two axes at the same time
 */
-set<line_segment> contour_pieces(edge h, set<stripe> S)
+void rank_coordinates(const rectangle* rect, size_t n, coordinate_ranks& ranks, vector<basic_edge<rank_t>>& VRX, vector<basic_edge<rank_t>>& HRX, const parallel_run& par)
 {
-	
-    stripe stemp;
-    if(h.edgetype=="TOP")
+    STATS_TIMER(T_RANK_COORDINATES);
+    //every coordinate is sorted together with its slot, 2k or 2k+1 for the ends of rectangle k, so one pass hands out the ranks without searching
+    vector<rank_t> x_rank(2*n), y_rank(2*n);
+    auto rank_axis = [&](vector<ll>& axis, vector<rank_t>& slot_rank, bool y)
     {
-        for(auto t : S)
+        vector<pair<ll,uint32_t>> slots(2*n);
+        for(size_t k=0;k<n;k++)
         {
-            if(t.y_int.bottom == h.x)
-            {
-                stemp = t;
-                break;
-            }
+            const interval& v = y ? rect[k].y_int : rect[k].x_int;
+            slots[2*k] = {v.bottom, uint32_t(2*k)};
+            slots[2*k+1] = {v.top, uint32_t(2*k+1)};
         }
-    }
-    else
-    {
-        for(auto t : S)
+        sort(slots.begin(), slots.end());
+        axis.clear();
+        for(auto& sl : slots)
         {
-            if(t.y_int.top == h.x)
+            if(axis.empty() or axis.back() != sl.first)
             {
-                stemp = t;
-                break;
+                axis.push_back(sl.first);
             }
+            slot_rank[sl.second] = axis.size()-1;
         }
-    }
-    
-
-    ll lower_X = h.i.bottom;
-    ll higher_X = h.i.top;
-    vector<ctree *> result;
-    set<interval> J;
-    inorder_find(stemp.tree, lower_X, higher_X, result);
-    
-    ll pointX = lower_X;
-    bool op = true;
-    for (auto it : result)
+    };
+    if(par.pool != NULL)
     {
-        if (it->lru == "LEFT")
-        {   
-            if (pointX < it->x)
-                J.insert({pointX, min(higher_X,it->x)});
-            op = false;
-        }
-        else if(it->x>=pointX)
-        {
-            pointX = it->x;
-            op = true;
-        }
+        task_group axes;
+        par.pool->spawn(axes, [&]() { rank_axis(ranks.xs, x_rank, false); });
+        rank_axis(ranks.ys, y_rank, true);
+        par.pool->wait(axes);
     }
-
-    if (op)
+    else
     {
-        if (pointX < higher_X)
-        {
-            J.insert({pointX, higher_X});
-        }
+        rank_axis(ranks.xs, x_rank, false);
+        rank_axis(ranks.ys, y_rank, true);
     }
-    set<line_segment> resultant_lines;
-    ll y = h.x;
-    for (auto it : J)
+    VRX.resize(2*n);
+    HRX.resize(2*n);
+    for(size_t k=0;k<n;k++)
     {
-        line_segment ls;
-        ls.inter = it;
-        ls.x = y;
-        resultant_lines.insert(ls);
+        basic_interval<rank_t> x_int = {x_rank[2*k], x_rank[2*k+1]};
+        basic_interval<rank_t> y_int = {y_rank[2*k], y_rank[2*k+1]};
+        VRX[2*k] = {x_int.bottom, y_int, int32_t(k), LEFT};
+        VRX[2*k+1] = {x_int.top, y_int, int32_t(k), RIGHT};
+        HRX[2*k] = {y_int.bottom, x_int, int32_t(k), BOTTOM};
+        HRX[2*k+1] = {y_int.top, x_int, int32_t(k), TOP};
     }
-
-    // cout << "Horizontal edge is : " << endl;
-    // cout << h.i.bottom << " " << h.i.top << " " << h.x << endl;
-    
-    // for (auto it : result)
-    // {
-    //     cout << it->x << " " << it->lru << endl;
-    // }
-    // cout << endl;
-
-    return resultant_lines;
 }
-
-/*! Function that computes all the horizontal contours generated using the horizontal edges from the input rectangles and the set of stripes
-    \param H Set of horizontal edges formed by the input rectangles
-    \param S defines the set of stripes that the frame is partitioned into
-    \return Set of line segments representing the horizontal contours for the union of input rectangles
+/*! Creates the edges of every rectangle with its coordinates converted to C, which must be able to hold all of them
+    \param rect defines the collection of iso oriented rectangles input by the users
+    \param n number of rectangles, fewer than 2^31; the position of a rectangle serves as its unique ID
+    \param VRX receives the left and right edges of all rectangles in input order
+    \param HRX receives the bottom and top edges of all rectangles in input order, with the y coordinate stored as the fixed coordinate
 */
-set<line_segment> contour(set<edge> H, set<stripe> S)   
+template<class C> void coordinate_edges(const rectangle* rect, size_t n, vector<basic_edge<C>>& VRX, vector<basic_edge<C>>& HRX)
 {
-	set<line_segment> ans_contour;
-
-	auto it=H.begin();
-	while(it!=H.end())
-	{
-		edge temp=(*it);
-        // cout<<"The horizontal edge is : "<<temp.x<<" "<<temp.i.bottom<<" "<<temp.i.top<<endl;
-		set<line_segment> ltemp=contour_pieces(temp,S);
-		auto it1=ltemp.begin();
-        while(it1!=ltemp.end())  
-        {
-            ans_contour.insert(*it1);
-            it1++;
-        }
-		it++;
-	}
-	return ans_contour;
+    VRX.resize(2*n);
+    HRX.resize(2*n);
+    for(size_t k=0;k<n;k++)
+    {
+        basic_interval<C> x_int = {C(rect[k].x_int.bottom), C(rect[k].x_int.top)};
+        basic_interval<C> y_int = {C(rect[k].y_int.bottom), C(rect[k].y_int.top)};
+        VRX[2*k] = {x_int.bottom, y_int, int32_t(k), LEFT};
+        VRX[2*k+1] = {x_int.top, y_int, int32_t(k), RIGHT};
+        HRX[2*k] = {y_int.bottom, x_int, int32_t(k), BOTTOM};
+        HRX[2*k+1] = {y_int.top, x_int, int32_t(k), TOP};
+    }
 }
-/*! Function that merges a set of overlapping intervals 
-    \param s Set of intervals to be merged 
-    \return Set of intervals containing intervals without overlap formed by merging the overlapping intervals in s
+/*! Transposes the edges of rectangles: x and y swap roles, so left and right edges become bottom and top edges and the other way round
+    \param from edges of the rectangles
+    \param to receives the same edges of the transposed rectangles, in the same order
 */
-set<interval> merge_intervals(set<interval> s)
+template<class C> void transpose_edges(const vector<basic_edge<C>>& from, vector<basic_edge<C>>& to)
 {
-    set<interval> ans;
-    interval itemp;
-    auto it = s.begin();
-    itemp.bottom = (*it).bottom;
-    itemp.top = (*it).top;
-    ++it;
-    while(it!=s.end())
+    //the coordinates stay as they are, only the axis they lie on changes; the table is indexed by TOP, BOTTOM, LEFT, RIGHT
+    const edge_tag SWAPPED[4] = {RIGHT, LEFT, BOTTOM, TOP};
+    to.resize(from.size());
+    for(size_t k=0;k<from.size();k++)
     {
-        interval cur = *it;
-        if(cur.bottom <= itemp.top)
-        {
-            itemp.top = max(cur.top,itemp.top);
-        }
-        else 
-        {
-            ans.insert(itemp);
-            itemp.bottom = cur.bottom;
-            itemp.top = cur.top;
-        }
-        ++it;
+        to[k] = from[k];
+        to[k].edgetype = SWAPPED[from[k].edgetype];
     }
-    ans.insert(itemp);
-    return ans;
 }
-/*! Function that writes the coordinates of the line segments that form the horizontal and vertical contours, along with the input rectangles into separate files for later use in visualization
-    \param hrc Set of horizontal line segments that form the horizontal contours
-    \param vrc Set of vertical line segments that form the vertical contours
+///Brief description of divide and conquer coordinates
+///
+///The coordinates that the divide and conquer runs on. Its edges, stripes, trees and interval sets are half as wide on 32 bits, so the narrowest choice that holds the input is taken
+enum dac_coordinates
+{
+    ///The coordinates themselves, narrowed to 32 bits
+    DAC_NARROW,
+    ///The 32 bit ranks of the coordinates
+    DAC_RANKED,
+    ///The 64 bit coordinates themselves, for inputs with more coordinates than 32 bit ranks can number
+    DAC_WIDE
+};
+/*! Chooses the narrowest coordinates that the divide and conquer can run on for a set of rectangles
+    \param rect defines the collection of iso oriented rectangles input by the users
+    \param n number of rectangles
+    \param frame receives the frame around the rectangles, which bounds the divide and conquer unless it runs on ranks
+    \return DAC_NARROW when the frame fits in 32 bits, otherwise DAC_RANKED when the ranks of the coordinates do, otherwise DAC_WIDE
 */
-void csv_writer(set<line_segment> hrc, set<line_segment> vrc)
+dac_coordinates choose_coordinates(const rectangle* rect, size_t n, rectangle& frame)
 {
-    std::ofstream myFile("rectangles.csv");
-    
-    
-    myFile << "Rectangles\n";
-    rectangle frame = findFrame();
-    myFile<< frame.x_int.bottom<<", "<<frame.x_int.top<<", "<<frame.y_int.bottom<<", "<<frame.y_int.top<<"\n";
-    auto iter = iso_rectangles_input.begin();
-    while(iter != iso_rectangles_input.end())
-    {
-        rectangle r = (*iter);
-        myFile<< r.x_int.bottom<<", "<<r.x_int.top<<", "<<r.y_int.bottom<<", "<<r.y_int.top<<"\n";
-        
-        iter++;
+    frame = findFrame(rect, n);
+    auto narrow = [](const interval& v) { return v.bottom >= numeric_limits<int32_t>::min() and v.top <= numeric_limits<int32_t>::max(); };
+    if(n == 0 or (narrow(frame.x_int) and narrow(frame.y_int)))
+    {
+        return DAC_NARROW;
     }
-    
-    myFile.close();
-
-    std::ofstream myFile2("contours.csv");
-    
+    //the 2n coordinates of an axis need 2n ranks, and the frame one more on either side
+    if(2*n < size_t(numeric_limits<rank_t>::max()))
+    {
+        return DAC_RANKED;
+    }
+    return DAC_WIDE;
+}
+/*! Driver function used to call the divide and conquer algorithm stripes when provided with the vertical edges of a set of iso-oriented rectangles
+    \param VRX the left and right edges of the rectangles, as made by coordinate_edges or rank_coordinates; they are sorted in place
+    \param xlimits the width of the frame, enclosing every x of VRX; it lies on the outermost x only where the margin ran into the limits of the coordinates
+    \param ylimits the height of the frame, enclosing every y of VRX in the same way
+    \param arena owns the ctree nodes of the returned stripes; they stay valid until the arena is reset or destroyed
+    \param par selects the task pool and cutoffs used to run the divide and conquer on several cores
+    \return Final stripes computed by the stripes algorithm, in the coordinates of VRX, sorted from bottom to top
+*/
+template<class C> vector<stripe<C>> rectangle_DAC(vector<basic_edge<C>>& VRX, basic_interval<C> xlimits, basic_interval<C> ylimits, ctree_arena<C>& arena, const parallel_run& par)
+{
+    STATS_TIMER(T_RECTANGLE_DAC);
+    //identical edges of different rectangles are all kept: L and R pair edges up by rectangle ID, so dropping one would leave its partner unmatched
+    stable_sort(VRX.begin(), VRX.end());
 
-    myFile2 << "Contours\n";
-    auto itc = hrc.begin();
-    while(itc != hrc.end())
+    vector<stripe<C>> S;
+    if(VRX.empty())
     {
-        line_segment ls = (*itc);
-        myFile2<< ls.inter.bottom<<", "<<ls.x<<", "<<ls.inter.top<<", "<<ls.x<<"\n";
-        itc++;
+        return S;
     }
-    auto itv = vrc.begin();
-    while(itv != vrc.end())
+    if(par.pool != NULL)
     {
-        line_segment ls = (*itv);
-        myFile2<< ls.x<<", "<<ls.inter.bottom<<", "<<ls.x<<", "<<ls.inter.top<<"\n";
-        itv++;
+        arena.reserve_workers(par.pool->size());
     }
+    size_t nodes_before = arena.node_count();
+    SRT<C> srt = stripes(VRX, 0, VRX.size(), xlimits, ylimits, arena, par);
+    STATS_COUNT(C_CTREE_NODES, arena.node_count()-nodes_before);
+    STATS_MEMORY_DONE(srt, arena.node_count()-nodes_before);
+    return std::move(srt.S);
     
-    myFile2.close();
 }
-
-int main()
+///Brief description of stripe index
+///
+///Maps a y coordinate to the final stripe that starts or ends there. It is built once after rectangle_DAC and only read afterwards, so concurrent contour queries can share it.
+///The bottoms and tops of the stripes are stored in Eytzinger (breadth first) order, so the search walks down an implicit binary tree whose top levels stay in cache
+template<class C> class stripe_index
 {
-   
-    ll n; 
-    cin>>n;
-    interval x,y;
-    ll x1,x2,y1,y2;
-    for(ll i=0;i<n;i++)
+public:
+    ///Indexes the stripes S, which must stay alive and unchanged while the index is in use
+    explicit stripe_index(const vector<stripe<C>>& S) : stripes(S)
     {
-        cin>>x1>>x2>>y1>>y2;
-        x.bottom = x1; 
-        x.top = x2;
-        y.bottom = y1;
-        y.top = y2;
-        rectangle r;
-        r.x_int = x;
-        r.y_int = y;
-        r.id = i;
-        iso_rectangles_input.push_back(r);
+        vector<C> keys(S.size());
+        for(size_t k=0;k<S.size();k++)
+        {
+            keys[k] = S[k].y_int.bottom;
+        }
+        build(keys, bottoms, bottom_pos);
+        for(size_t k=0;k<S.size();k++)
+        {
+            keys[k] = S[k].y_int.top;
+        }
+        build(keys, tops, top_pos);
+    }
+
+    ///Returns the stripe whose lower boundary is y, or NULL when there is none
+    const stripe<C>* starting_at(C y) const
+    {
+        size_t k = search(bottoms, y);
+        return k == 0 ? NULL : &stripes[bottom_pos[k]];
+    }
+
+    ///Returns the stripe whose upper boundary is y, or NULL when there is none
+    const stripe<C>* ending_at(C y) const
+    {
+        size_t k = search(tops, y);
+        return k == 0 ? NULL : &stripes[top_pos[k]];
+    }
+
+private:
+    ///Lays the sorted keys out in Eytzinger order, slot 0 unused, and records the stripe that each slot came from
+    static void build(const vector<C>& keys, vector<C>& tree, vector<uint32_t>& pos)
+    {
+        tree.assign(keys.size()+1, 0);
+        pos.assign(keys.size()+1, 0);
+        size_t next = 0;
+        fill(keys, tree, pos, next, 1);
+    }
+
+    static void fill(const vector<C>& keys, vector<C>& tree, vector<uint32_t>& pos, size_t& next, size_t k)
+    {
+        if(k < tree.size())
+        {
+            fill(keys, tree, pos, next, 2*k);
+            tree[k] = keys[next];
+            pos[k] = next++;
+            fill(keys, tree, pos, next, 2*k+1);
+        }
+    }
+
+    ///Returns the slot holding exactly y, or 0 when y is not a key
+    static size_t search(const vector<C>& tree, C y)
+    {
+        size_t n = tree.size();
+        size_t k = 1;
+        while(k < n)
+        {
+            k = 2*k + (tree[k] < y);
+        }
+        //undo the right turns taken after the last left turn, which leaves the lower bound of y
+        k >>= __builtin_ffsll(~k);
+        return (k != 0 and tree[k] == y) ? k : 0;
+    }
+
+    ///The indexed stripes, sorted from bottom to top
+    const vector<stripe<C>>& stripes;
+    ///Lower boundaries of the stripes in Eytzinger order, and the stripe each one belongs to
+    vector<C> bottoms;
+    vector<uint32_t> bottom_pos;
+    ///Upper boundaries of the stripes in Eytzinger order, and the stripe each one belongs to
+    vector<C> tops;
+    vector<uint32_t> top_pos;
+};
+
+/*! Fumction to compute the horizontal contours associated with the given edge and the set of stripes
+    \param h Horizontal edge which is part of an input rectangle
+    \param index locates the stripe directly above a top edge or directly below a bottom edge
+    \param resultant_lines receives the line segments representing the horizontal contours associated with the current edge, in the coordinates of h; they are appended unsorted and may repeat
+*/
+template<class C> void contour_pieces(const basic_edge<C>& h, const stripe_index<C>& index, vector<line_segment>& resultant_lines)
+{
+	
+    const stripe<C>* stemp;
+    if(h.edgetype==TOP)
+    {
+        stemp = index.starting_at(h.x);
+    }
+    else
+    {
+        stemp = index.ending_at(h.x);
     }
-    rectangle frame = findFrame();
-   
     
-    set<stripe> S = rectangle_DAC(iso_rectangles_input);
-   
 
-    vector<rectangle>::iterator it = iso_rectangles_input.begin();
-    set<edge> HRX;
-    while(it != iso_rectangles_input.end())
+    C lower_X = h.i.bottom;
+    C higher_X = h.i.top;
+    vector<ctree<C> *> result;
+    inorder_find(stemp == NULL ? NULL : stemp->tree, lower_X, higher_X, result);
+    
+    line_segment ls;
+    ls.x = h.x;
+    C pointX = lower_X;
+    bool op = true;
+    for (auto it : result)
+    {
+        if (it->lru == LEFT)
+        {   
+            if (pointX < min(higher_X,it->x))
+            {
+                ls.inter = {pointX, min(higher_X,it->x)};
+                resultant_lines.push_back(ls);
+            }
+            op = false;
+        }
+        else if(it->x>=pointX)
+        {
+            pointX = it->x;
+            op = true;
+        }
+    }
+
+    if (op)
+    {
+        if (pointX < higher_X)
+        {
+            ls.inter = {pointX, higher_X};
+            resultant_lines.push_back(ls);
+        }
+    }
+}
+
+/*! Packs a corner of the contour into one integer that sorts like the pair (x, y)
+    \param x the x coordinate or rank of the corner
+    \param y the y coordinate or rank of the corner
+    \return x and y, offset to unsigned, in the high and the low half
+*/
+inline uint64_t corner_key(int32_t x, int32_t y)
+{
+    return uint64_t(uint32_t(x)^0x80000000u) << 32 | (uint32_t(y)^0x80000000u);
+}
+/*! Keeps a corner with 64 bit coordinates as the pair (x, y), since there is no wider integer to pack it into
+    \param x the x coordinate of the corner
+    \param y the y coordinate of the corner
+    \return The pair (x, y)
+*/
+inline pair<ll,ll> corner_key(ll x, ll y)
+{
+    return {x, y};
+}
+///Returns the x of a corner packed by corner_key
+inline int32_t corner_x(uint64_t key) { return int32_t(uint32_t(key >> 32)^0x80000000u); }
+inline ll corner_x(const pair<ll,ll>& key) { return key.first; }
+///Returns the y of a corner packed by corner_key
+inline int32_t corner_y(uint64_t key) { return int32_t(uint32_t(key)^0x80000000u); }
+inline ll corner_y(const pair<ll,ll>& key) { return key.second; }
+
+/*! Sorts packed corners with a least significant digit radix sort, 16 bits per pass, which beats a comparison sort well once the corners number in the millions. A pass over a digit that every key shares is skipped
+    \param keys the keys to sort in place
+*/
+void sort_corners(vector<uint64_t>& keys)
+{
+    const int DIGIT = 16;
+    const size_t BUCKETS = size_t(1) << DIGIT;
+    vector<uint64_t> buffer(keys.size());
+    vector<size_t> count(BUCKETS);
+    for(int shift=0;shift<64 and not keys.empty();shift+=DIGIT)
+    {
+        fill(count.begin(), count.end(), 0);
+        for(uint64_t k : keys)
+        {
+            count[(k >> shift) & (BUCKETS-1)]++;
+        }
+        if(count[(keys[0] >> shift) & (BUCKETS-1)] == keys.size())
+        {
+            continue;
+        }
+        size_t sum = 0;
+        for(size_t b=0;b<BUCKETS;b++)
+        {
+            size_t c = count[b];
+            count[b] = sum;
+            sum += c;
+        }
+        for(uint64_t k : keys)
+        {
+            buffer[count[(k >> shift) & (BUCKETS-1)]++] = k;
+        }
+        keys.swap(buffer);
+    }
+}
+/*! Sorts corners with 64 bit coordinates
+    \param keys the keys to sort in place
+*/
+void sort_corners(vector<pair<ll,ll>>& keys)
+{
+    sort(keys.begin(), keys.end());
+}
+
+/*! Function that computes all the contours of the union from the horizontal edges of the input rectangles and the set of stripes, in one streaming pass over the edges.
+    The edges are cut into chunks where y changes. Every chunk queries the stripes for the pieces of its edges and merges the pieces on each y into maximal segments as it goes, so the chunks, taken in order, already hold the sorted horizontal contours.
+    The ends of those segments are collected on the way, and paired up into the vertical contours once sorted by x, unless the vertical contours come from elsewhere
+    \param H Horizontal edges formed by the input rectangles, in coordinates or in ranks, sorted
+    \param index locates the stripes that the frame is partitioned into
+    \param ranks the coordinates the ranks of H stand for, or NULL when H holds the coordinates themselves
+    \param par selects the task pool that the chunks of H are spread over
+    \param horizontal receives the merged horizontal contours in coordinates, sorted
+    \param vertical receives the vertical contours in coordinates, sorted, unless NULL
+    \return Number of distinct horizontal contour pieces before merging
+*/
+template<class C> size_t contour(const vector<basic_edge<C>>& H, const stripe_index<C>& index, const coordinate_ranks* ranks, const parallel_run& par, vector<line_segment>& horizontal, vector<line_segment>* vertical)
+{
+    typedef decltype(corner_key(C(), C())) corner;
+    size_t chunk = max<size_t>(par.contour_chunk,1);
+    //a chunk only ends where y changes, so every y is merged by one chunk
+    vector<size_t> cuts = {0};
+    for(size_t k=chunk;k<H.size();k+=chunk)
+    {
+        while(k < H.size() and H[k].x == H[k-1].x)
+        {
+            k++;
+        }
+        if(k < H.size())
+        {
+            cuts.push_back(k);
+        }
+    }
+    cuts.push_back(H.size());
+    size_t chunks = cuts.size()-1;
+    //every chunk owns its buffers, so the result does not depend on which worker ran which chunk
+    vector<vector<line_segment>> runs(chunks);
+    vector<vector<corner>> corners(chunks);
+    vector<size_t> distinct(chunks, 0);
+    {
+        STATS_TIMER(T_CONTOUR);
+        parallel_for(par.pool, chunks, 1, [&](size_t first, size_t last)
+        {
+            vector<line_segment> pieces;
+            for(size_t c=first;c<last;c++)
+            {
+                for(size_t k=cuts[c];k<cuts[c+1];)
+                {
+                    //the pieces of one edge come out sorted, those of several edges on the same y need a sort before merging
+                    size_t end = k;
+                    pieces.clear();
+                    for(;end<cuts[c+1] and H[end].x == H[k].x;end++)
+                    {
+                        contour_pieces(H[end],index,pieces);
+                    }
+                    if(end-k > 1)
+                    {
+                        sort(pieces.begin(), pieces.end());
+                    }
+                    for(size_t p=0;p<pieces.size();)
+                    {
+                        line_segment run = pieces[p];
+                        distinct[c]++;
+                        for(p++;p<pieces.size() and pieces[p].inter.bottom <= run.inter.top;p++)
+                        {
+                            distinct[c] += pieces[p-1] < pieces[p];
+                            run.inter.top = max(run.inter.top, pieces[p].inter.top);
+                        }
+                        if(vertical != NULL)
+                        {
+                            corners[c].push_back(corner_key(C(run.inter.bottom), C(run.x)));
+                            corners[c].push_back(corner_key(C(run.inter.top), C(run.x)));
+                        }
+                        //ranks keep the order of their coordinates, so the runs stay sorted
+                        if(ranks != NULL)
+                        {
+                            run.x = ranks->ys[run.x];
+                            run.inter.bottom = ranks->xs[run.inter.bottom];
+                            run.inter.top = ranks->xs[run.inter.top];
+                        }
+                        runs[c].push_back(run);
+                    }
+                    k = end;
+                }
+            }
+        });
+    }
+    size_t segments = 0, pieces = 0;
+    for(size_t c=0;c<chunks;c++)
+    {
+        segments += runs[c].size();
+        pieces += distinct[c];
+    }
+    horizontal.clear();
+    horizontal.reserve(segments);
+    vector<corner> points;
+    points.reserve(vertical == NULL ? 0 : 2*segments);
+    for(size_t c=0;c<chunks;c++)
+    {
+        horizontal.insert(horizontal.end(), runs[c].begin(), runs[c].end());
+        points.insert(points.end(), corners[c].begin(), corners[c].end());
+        vector<line_segment>().swap(runs[c]);
+        vector<corner>().swap(corners[c]);
+    }
+    STATS_COUNT(C_PIECES_UNMERGED, pieces);
+    STATS_COUNT(C_PIECES_MERGED, horizontal.size());
+    if(vertical == NULL)
+    {
+        return pieces;
+    }
+    STATS_TIMER(T_PAIR_VERTICAL);
+    sort_corners(points);
+    //an odd point out cannot be paired; it only arises if the horizontal contours are inconsistent
+    vertical->resize(points.size()/2);
+    for(size_t k=0;k<vertical->size();k++)
+    {
+        line_segment& v = (*vertical)[k];
+        v.x = corner_x(points[2*k]);
+        v.inter.bottom = corner_y(points[2*k]);
+        v.inter.top = corner_y(points[2*k+1]);
+        if(ranks != NULL)
+        {
+            v.x = ranks->xs[v.x];
+            v.inter.bottom = ranks->ys[v.inter.bottom];
+            v.inter.top = ranks->ys[v.inter.top];
+        }
+    }
+    STATS_COUNT(C_VERTICAL_SEGMENTS, vertical->size());
+    return pieces;
+}
+//the divide and conquer is instantiated for 32 bit coordinates or ranks and for 64 bit coordinates
+template vector<stripe<int32_t>> rectangle_DAC(vector<basic_edge<int32_t>>&, basic_interval<int32_t>, basic_interval<int32_t>, ctree_arena<int32_t>&, const parallel_run&);
+template vector<stripe<ll>> rectangle_DAC(vector<basic_edge<ll>>&, basic_interval<ll>, basic_interval<ll>, ctree_arena<ll>&, const parallel_run&);
+template size_t contour(const vector<basic_edge<int32_t>>&, const stripe_index<int32_t>&, const coordinate_ranks*, const parallel_run&, vector<line_segment>&, vector<line_segment>*);
+template size_t contour(const vector<basic_edge<ll>>&, const stripe_index<ll>&, const coordinate_ranks*, const parallel_run&, vector<line_segment>&, vector<line_segment>*);
+/*! Creates the bottom and top edges of every rectangle
+    \param rect defines the collection of iso oriented rectangles input by the users
+    \param n number of rectangles; the position of a rectangle serves as its unique ID
+    \param HRX receives the horizontal edges of all rectangles in input order, with the y coordinate stored as the fixed coordinate
+*/
+void horizontal_edges(const rectangle* rect, size_t n, vector<edge>& HRX)
+{
+    HRX.clear();
+    HRX.reserve(2*n);
+    for(size_t k=0;k<n;k++)
     {
         edge e1;
-        e1.edgetype = "BOTTOM";
-        e1.i = (*it).x_int;
-        e1.x =  (*it).y_int.bottom;
-        e1.rect_id=(*it).id;
+        e1.edgetype = BOTTOM;
+        e1.i = rect[k].x_int;
+        e1.x =  rect[k].y_int.bottom;
+        e1.rect_id=k;
 
         edge e2;
-        e2.edgetype = "TOP";
-        e2.i = (*it).x_int;
-        e2.x =  (*it).y_int.top;
-        e2.rect_id=(*it).id;
+        e2.edgetype = TOP;
+        e2.i = rect[k].x_int;
+        e2.x =  rect[k].y_int.top;
+        e2.rect_id=k;
 
-        HRX.insert(e1);
-        HRX.insert(e2);
-        it++;
+        HRX.push_back(e1);
+        HRX.push_back(e2);
+    }
+}
+
+///Brief description of coverage tree
+///
+///Segment tree over the elementary intervals between consecutive distinct x coordinates. Every node counts the rectangles covering its whole range, without pushing the count down, and keeps the covered length of its range, and on request the number of maximal covered runs in it.
+///That is enough for a plane sweep to list the uncovered parts of an edge in time proportional to their number
+class coverage_tree
+{
+public:
+    ///Builds an empty tree over the sorted, distinct coordinates xs, which keeps the number of covered runs when count_runs is set
+    explicit coverage_tree(const vector<ll>& xs, bool count_runs = false) : xs(xs), leaves(xs.size() < 2 ? 0 : xs.size()-1), cnt(4*max<size_t>(leaves,1),0), len(4*max<size_t>(leaves,1),0)
+    {
+        if(count_runs)
+        {
+            runs.assign(cnt.size(), 0);
+            ends.assign(cnt.size(), 0);
+        }
     }
-    set<line_segment> horizontal_contours_unmerged = contour(HRX,S);
-    
 
+    ///Total covered length; it can exceed the range of ll, never that of uint64_t
+    uint64_t covered_length() const
+    {
+        return len[1];
+    }
 
-    map<ll, set<interval>> merged_horizontal_contours;
-    for (auto h : horizontal_contours_unmerged)
+    ///Number of maximal covered runs; 0 unless the tree was built with count_runs
+    size_t covered_runs() const
     {
-        interval i1;
-        i1.bottom = h.inter.bottom;
-        i1.top = h.inter.top;
-        merged_horizontal_contours[h.x].insert(i1);
+        return runs.empty() ? 0 : runs[1];
     }
 
-    
+    ///Adds delta to the cover count of the x range [lo, hi]; lo and hi must be coordinates the tree was built with
+    void add(ll lo, ll hi, int delta)
+    {
+        size_t a = lower_bound(xs.begin(), xs.end(), lo) - xs.begin();
+        size_t b = lower_bound(xs.begin(), xs.end(), hi) - xs.begin();
+        if(a < b)
+        {
+            update(1, 0, leaves, a, b, delta);
+        }
+    }
 
-    vector<pair<ll,ll>> vertical_contours_points;
+    ///Appends the maximal uncovered parts of [lo, hi] as line segments at height y, from left to right
+    void uncovered(ll lo, ll hi, ll y, vector<line_segment>& out) const
+    {
+        size_t a = lower_bound(xs.begin(), xs.end(), lo) - xs.begin();
+        size_t b = lower_bound(xs.begin(), xs.end(), hi) - xs.begin();
+        size_t first = out.size();
+        if(a < b)
+        {
+            collect(1, 0, leaves, a, b, y, out, first);
+        }
+    }
+
+private:
+    void update(size_t node, size_t l, size_t r, size_t a, size_t b, int delta)
+    {
+        if(a <= l and r <= b)
+        {
+            cnt[node] += delta;
+        }
+        else
+        {
+            size_t m = (l+r)/2;
+            if(a < m)
+            {
+                update(2*node, l, m, a, b, delta);
+            }
+            if(m < b)
+            {
+                update(2*node+1, m, r, a, b, delta);
+            }
+        }
+        if(cnt[node] > 0)
+        {
+            len[node] = uint64_t(xs[r])-uint64_t(xs[l]);
+        }
+        else if(r-l == 1)
+        {
+            len[node] = 0;
+        }
+        else
+        {
+            len[node] = len[2*node]+len[2*node+1];
+        }
+        if(runs.empty())
+        {
+            return;
+        }
+        //bit 0 of ends tells whether the range of a node is covered at its left end, bit 1 at its right end
+        if(cnt[node] > 0)
+        {
+            runs[node] = 1;
+            ends[node] = 3;
+        }
+        else if(r-l == 1)
+        {
+            runs[node] = 0;
+            ends[node] = 0;
+        }
+        else
+        {
+            runs[node] = runs[2*node]+runs[2*node+1]-((ends[2*node] & 2) and (ends[2*node+1] & 1));
+            ends[node] = (ends[2*node] & 1) | (ends[2*node+1] & 2);
+        }
+    }
 
-    for(auto h : merged_horizontal_contours)
+    void collect(size_t node, size_t l, size_t r, size_t a, size_t b, ll y, vector<line_segment>& out, size_t first) const
     {
-        set<interval> s1 = merge_intervals(h.second);
-        merged_horizontal_contours[h.first] =  s1;
-        for(auto siter : s1)
+        if(cnt[node] > 0)
+        {
+            return;
+        }
+        if(len[node] == 0 or r-l == 1)
+        {
+            ll lo = xs[max(l,a)];
+            ll hi = xs[min(r,b)];
+            //extend the previous piece when the two touch
+            if(out.size() > first and out.back().inter.top == lo)
+            {
+                out.back().inter.top = hi;
+            }
+            else
+            {
+                line_segment ls;
+                ls.inter = {lo, hi};
+                ls.x = y;
+                out.push_back(ls);
+            }
+            return;
+        }
+        size_t m = (l+r)/2;
+        if(a < m)
+        {
+            collect(2*node, l, m, a, b, y, out, first);
+        }
+        if(m < b)
         {
-            interval temp = siter;
-            pair<ll,ll> p1;
-            p1.first = temp.bottom;
-            p1.second = h.first;
-            vertical_contours_points.push_back(p1);
-            p1.first = temp.top;
-            vertical_contours_points.push_back(p1);
+            collect(2*node+1, m, r, a, b, y, out, first);
         }
     }
-    set<line_segment> horizontal_contours;
 
+    ///Distinct x coordinates; leaf k stands for the range [xs[k], xs[k+1]]
+    vector<ll> xs;
+    ///Number of elementary intervals
+    size_t leaves;
+    ///Number of rectangles covering the whole range of a node
+    vector<int> cnt;
+    ///Covered length inside the range of a node, unsigned since a range may span more than the largest ll
+    vector<uint64_t> len;
+    ///Maximal covered runs inside the range of a node, only kept with count_runs
+    vector<int> runs;
+    ///Whether the range of a node is covered at its ends, only kept with count_runs
+    vector<uint8_t> ends;
+};
 
-    
-    for (auto h : merged_horizontal_contours)
+/*! Computes the horizontal contour pieces with a plane sweep from bottom to top. At every y the uncovered parts of the bottom edges are read before the edges at y are applied, and those of the top edges after
+    \param rect defines the collection of iso oriented rectangles input by the users
+    \param n number of rectangles
+    \param H scratch buffer for the horizontal edges, kept by the caller so that its memory is reused
+    \param pieces receives the horizontal contour pieces, sorted and free of duplicates but not merged
+*/
+void sweep_contour(const rectangle* rect, size_t n, vector<edge>& H, vector<line_segment>& pieces)
+{
+    STATS_TIMER(T_SWEEP_CONTOUR);
+    vector<ll> xs;
+    xs.reserve(2*n);
+    for(size_t i=0;i<n;i++)
+    {
+        xs.push_back(rect[i].x_int.bottom);
+        xs.push_back(rect[i].x_int.top);
+    }
+    sort(xs.begin(), xs.end());
+    xs.erase(unique(xs.begin(), xs.end()), xs.end());
+    coverage_tree tree(xs);
+
+    //every edge is an event, even when another rectangle has an identical one, so that the cover counts balance
+    horizontal_edges(rect, n, H);
+    sort(H.begin(), H.end(), [](const edge& a, const edge& b) { return a.x < b.x; });
+    pieces.clear();
+    size_t k = 0;
+    while(k < H.size())
+    {
+        size_t end = k;
+        while(end < H.size() and H[end].x == H[k].x)
+        {
+            end++;
+        }
+        for(size_t j=k;j<end;j++)
+        {
+            if(H[j].edgetype == BOTTOM)
+            {
+                tree.uncovered(H[j].i.bottom, H[j].i.top, H[j].x, pieces);
+            }
+        }
+        for(size_t j=k;j<end;j++)
+        {
+            tree.add(H[j].i.bottom, H[j].i.top, H[j].edgetype == BOTTOM ? 1 : -1);
+        }
+        for(size_t j=k;j<end;j++)
+        {
+            if(H[j].edgetype == TOP)
+            {
+                tree.uncovered(H[j].i.bottom, H[j].i.top, H[j].x, pieces);
+            }
+        }
+        k = end;
+    }
+    sort(pieces.begin(), pieces.end());
+    pieces.erase(unique(pieces.begin(), pieces.end(), [](const line_segment& a, const line_segment& b) { return !(a < b) and !(b < a); }), pieces.end());
+}
+/*! Measures the union of the rectangles with the sweep of sweep_contour, without materializing the contour: the covered length and the covered runs of the coverage tree give the area and the vertical contours of every slab between two event heights, and the contour pieces of one height at a time give the horizontal contours
+    \param rect defines the collection of iso oriented rectangles input by the users; ones without area are skipped
+    \param n number of rectangles
+    \param H scratch buffer for the horizontal edges, kept by the caller so that its memory is reused
+    \param pieces scratch buffer for the contour pieces of one height
+    \param out receives the measures
+*/
+void sweep_measures(const rectangle* rect, size_t n, vector<edge>& H, vector<line_segment>& pieces, union_measures& out)
+{
+    STATS_TIMER(T_MEASURE);
+    horizontal_edges(rect, n, H);
+    H.erase(remove_if(H.begin(), H.end(), [rect](const edge& e)
+    {
+        const rectangle& r = rect[e.rect_id];
+        return r.x_int.bottom >= r.x_int.top or r.y_int.bottom >= r.y_int.top;
+    }), H.end());
+    vector<ll> xs;
+    xs.reserve(H.size());
+    for(size_t k=0;k<H.size();k+=2)
+    {
+        xs.push_back(H[k].i.bottom);
+        xs.push_back(H[k].i.top);
+    }
+    sort(xs.begin(), xs.end());
+    xs.erase(unique(xs.begin(), xs.end()), xs.end());
+    coverage_tree tree(xs, true);
+    vector<ll>().swap(xs);
+
+    sort(H.begin(), H.end(), [](const edge& a, const edge& b) { return a.x < b.x; });
+    //differences of ll coordinates are taken in uint64_t, which holds them exactly, and summed in measure_int, which never overflows
+    measure_int area = 0, horizontal = 0, vertical = 0;
+    size_t segments = 0;
+    size_t k = 0;
+    while(k < H.size())
+    {
+        ll y = H[k].x;
+        if(k > 0)
+        {
+            uint64_t dy = uint64_t(y)-uint64_t(H[k-1].x);
+            area += measure_int(tree.covered_length())*dy;
+            vertical += 2*measure_int(tree.covered_runs())*dy;
+        }
+        size_t end = k;
+        while(end < H.size() and H[end].x == y)
+        {
+            end++;
+        }
+        pieces.clear();
+        for(size_t j=k;j<end;j++)
+        {
+            if(H[j].edgetype == BOTTOM)
+            {
+                tree.uncovered(H[j].i.bottom, H[j].i.top, y, pieces);
+            }
+        }
+        for(size_t j=k;j<end;j++)
+        {
+            tree.add(H[j].i.bottom, H[j].i.top, H[j].edgetype == BOTTOM ? 1 : -1);
+        }
+        for(size_t j=k;j<end;j++)
+        {
+            if(H[j].edgetype == TOP)
+            {
+                tree.uncovered(H[j].i.bottom, H[j].i.top, y, pieces);
+            }
+        }
+        //the pieces of one height merged as merge_contours does, touching ones included, are the horizontal contours at that height
+        sort(pieces.begin(), pieces.end());
+        ll top = 0;
+        for(size_t p=0;p<pieces.size();p++)
+        {
+            const interval& c = pieces[p].inter;
+            if(p > 0 and c.bottom <= top)
+            {
+                horizontal += uint64_t(max(c.top, top))-uint64_t(top);
+                top = max(c.top, top);
+                continue;
+            }
+            horizontal += uint64_t(c.top)-uint64_t(c.bottom);
+            top = c.top;
+            segments++;
+        }
+        k = end;
+    }
+    out.area = area;
+    out.horizontal_length = horizontal;
+    out.vertical_length = vertical;
+    out.perimeter = horizontal+vertical;
+    out.vertices = 2*segments;
+}
+
+/*! Merges the horizontal contour pieces lying on the same y into maximal segments
+    \param pieces Horizontal contour pieces, sorted, as returned by contour or sweep_contour
+    \param vertical_contours_points receives both end points of every merged segment, as (x, y) pairs
+    \return Merged horizontal contours, sorted
+*/
+vector<line_segment> merge_contours(const vector<line_segment>& pieces, vector<pair<ll,ll>>& vertical_contours_points)
+{
+    STATS_COUNT(C_PIECES_UNMERGED, pieces.size());
+    vector<line_segment> horizontal_contours;
+    if(not pieces.empty())
     {
-        for(auto val : h.second)
+        STATS_TIMER(T_MERGE_INTERVALS);
+        //the pieces are sorted by y and then x, so a piece extends the segment before it exactly when it lies on the same y and starts at or before its end
+        horizontal_contours.reserve(pieces.size());
+        line_segment run = pieces[0];
+        for(size_t i=1;i<pieces.size();i++)
         {
-            line_segment ls;
-            ls.inter.bottom = val.bottom;
-            ls.inter.top = val.top;
-            ls.x = h.first;
-            horizontal_contours.insert(ls);
-            
+            const line_segment& p = pieces[i];
+            if(p.x == run.x and p.inter.bottom <= run.inter.top)
+            {
+                run.inter.top = max(run.inter.top, p.inter.top);
+            }
+            else
+            {
+                horizontal_contours.push_back(run);
+                run = p;
+            }
         }
+        horizontal_contours.push_back(run);
     }
-    cout << "Horizontal Contours\n";
-    for(auto lsi : horizontal_contours)
+    vertical_contours_points.reserve(vertical_contours_points.size()+2*horizontal_contours.size());
+    for(const line_segment& h : horizontal_contours)
     {
-        cout<<lsi.inter.bottom<<" "<<lsi.x<<"     "<<lsi.inter.top<<" "<<lsi.x<<endl;
+        vertical_contours_points.push_back({h.inter.bottom, h.x});
+        vertical_contours_points.push_back({h.inter.top, h.x});
     }
+    STATS_COUNT(C_PIECES_MERGED, horizontal_contours.size());
+    return horizontal_contours;
+}
+/*! Pairs up the end points of the merged horizontal contours into the vertical contours
+    \param vertical_contours_points End points collected by merge_contours; they are sorted in place
+    \return Vertical contours, with x the fixed coordinate and the interval spanning y, sorted
+*/
+vector<line_segment> pair_vertical_contours(vector<pair<ll,ll>>& vertical_contours_points)
+{
+    STATS_TIMER(T_PAIR_VERTICAL);
     sort(vertical_contours_points.begin(),vertical_contours_points.end());
-    
-    set<line_segment> vertical_contours;
-    auto vit = vertical_contours_points.begin();
-    cout<<"Vertical Contours\n";
-    while(vit!= vertical_contours_points.end())
-    {
-        pair<ll,ll> p1;
-        p1.first = (*vit).first; 
-        p1.second = (*vit).second;
-        line_segment l1;
-        l1.x = p1.first;
-        l1.inter.bottom = p1.second;
-        vit++;
-        p1.second = (*vit).second;
-        l1.inter.top = p1.second;
-        vertical_contours.insert(l1);
-        vit++;           
-        cout<<l1.x<<" "<<l1.inter.bottom<<"     "<<l1.x<<" "<<l1.inter.top<<endl;
-
-    }
-
-    csv_writer(horizontal_contours,vertical_contours);
-}
\ No newline at end of file
+    //an odd point out cannot be paired; it only arises if the horizontal contours are inconsistent
+    vector<line_segment> vertical_contours(vertical_contours_points.size()/2);
+    for(size_t k=0;k<vertical_contours.size();k++)
+    {
+        vertical_contours[k].x = vertical_contours_points[2*k].first;
+        vertical_contours[k].inter.bottom = vertical_contours_points[2*k].second;
+        vertical_contours[k].inter.top = vertical_contours_points[2*k+1].second;
+    }
+    STATS_COUNT(C_VERTICAL_SEGMENTS, vertical_contours.size());
+    return vertical_contours;
+}
+/*! Pairs every horizontal corner with the vertical corner at the same point. Corner 2i is the lower end of segment i and corner 2i+1 its upper end, so corner^1 is the other end of the same segment
+    \param hrc Horizontal contours, sorted
+    \param vrc Vertical contours, sorted
+    \param crossings The points where the contours cross and which are corners of both, sorted by y and then x, each with whether its lower left quadrant is covered
+    \param h_to_v Vertical corner of every horizontal corner
+    \param v_to_h Horizontal corner of every vertical corner
+    \return false if the corners do not pair up
+*/
+bool match_corners(const vector<line_segment>& hrc, const vector<line_segment>& vrc, const vector<pair<point,bool>>& crossings, vector<uint32_t>& h_to_v, vector<uint32_t>& v_to_h)
+{
+    size_t corners = 2*hrc.size();
+    //horizontal corners in their natural order are sorted by y and then x, vertical ones are sorted to match; at a crossing the upper ends come first, so the arm going west meets the arm going south
+    typedef struct corner_key
+    {
+        ll y, x;
+        uint32_t corner;
+        bool operator<(const corner_key& o) const
+        {
+            return y < o.y or (y == o.y and (x < o.x or (x == o.x and (corner&1) > (o.corner&1))));
+        }
+    }corner_key;
+    vector<corner_key> vk(corners);
+    for(size_t c=0;c<corners;c++)
+    {
+        vk[c] = {c&1 ? vrc[c/2].inter.top : vrc[c/2].inter.bottom, vrc[c/2].x, uint32_t(c)};
+    }
+    sort(vk.begin(), vk.end());
+    //every corner closes one horizontal and one vertical contour, so both sorted lists name the same points
+    h_to_v.assign(corners, 0);
+    v_to_h.assign(corners, 0);
+    size_t crossing = 0;
+    for(size_t k=0;k<corners;k++)
+    {
+        ll x = k&1 ? hrc[k/2].inter.top : hrc[k/2].inter.bottom, y = hrc[k/2].x;
+        if(x != vk[k].x or y != vk[k].y)
+        {
+            return false;
+        }
+        if(k+1 < corners and crossing < crossings.size() and x == crossings[crossing].first.x and y == crossings[crossing].first.y)
+        {
+            //west with south and east with north wrap the lower left and upper right quadrants; the other way round when those are open
+            bool swap_arms = not crossings[crossing].second;
+            h_to_v[k] = vk[k+swap_arms].corner;
+            v_to_h[vk[k+swap_arms].corner] = k;
+            h_to_v[k+1] = vk[k+1-swap_arms].corner;
+            v_to_h[vk[k+1-swap_arms].corner] = k+1;
+            crossing++;
+            k++;
+            continue;
+        }
+        h_to_v[k] = vk[k].corner;
+        v_to_h[vk[k].corner] = k;
+    }
+    return crossing == crossings.size();
+}
+
+/*! Finds the points where a horizontal and a vertical contour cross. The merged contours cross only where two parts of the union touch at a corner, and the four quadrants around such a point are covered alternately
+    \param hrc Horizontal contours, sorted
+    \param vrc Vertical contours, sorted
+    \param h_to_v Vertical corner of every horizontal corner, as paired by match_corners
+    \return The crossings sorted by y and then x, each with whether its lower left quadrant is covered
+*/
+vector<pair<point,bool>> contour_crossings(const vector<line_segment>& hrc, const vector<line_segment>& vrc, const vector<uint32_t>& h_to_v)
+{
+    //sweep upwards, counting the vertical contours with bottom < y <= top by x in a Fenwick tree. Horizontal contours are met by these only at crossings, and a point left of x is covered below y when an odd number of them lies left of it.
+    //The ends of every horizontal contour are corners of vertical ones, so their columns need no search
+    vector<uint32_t> column(vrc.size());
+    vector<ll> xs;
+    xs.reserve(vrc.size());
+    for(size_t k=0;k<vrc.size();k++)
+    {
+        if(xs.empty() or xs.back() != vrc[k].x)
+        {
+            xs.push_back(vrc[k].x);
+        }
+        column[k] = xs.size()-1;
+    }
+    vector<pair<ll,uint32_t>> bottoms(vrc.size()), tops(vrc.size());
+    for(size_t k=0;k<vrc.size();k++)
+    {
+        bottoms[k] = {vrc[k].inter.bottom, column[k]};
+        tops[k] = {vrc[k].inter.top, column[k]};
+    }
+    sort(bottoms.begin(), bottoms.end());
+    sort(tops.begin(), tops.end());
+    vector<int> fenwick(xs.size()+1, 0);
+    size_t high_bit = 1;
+    while(2*high_bit <= xs.size())
+    {
+        high_bit *= 2;
+    }
+    auto count = [&](uint32_t at, int delta)
+    {
+        for(size_t i=at+1;i<=xs.size();i+=i&-i)
+        {
+            fenwick[i] += delta;
+        }
+    };
+    //number of counted columns before column at
+    auto before = [&](size_t at)
+    {
+        int c = 0;
+        for(size_t i=at;i>0;i-=i&-i)
+        {
+            c += fenwick[i];
+        }
+        return c;
+    };
+    //the column holding the k-th counted contour, k from 1
+    auto kth = [&](int k)
+    {
+        size_t at = 0;
+        for(size_t step=high_bit;step>0;step/=2)
+        {
+            if(at+step <= xs.size() and fenwick[at+step] < k)
+            {
+                at += step;
+                k -= fenwick[at];
+            }
+        }
+        return at;
+    };
+    size_t added = 0, removed = 0;
+    vector<pair<point,bool>> crossings;
+    for(size_t i=0;i<hrc.size();i++)
+    {
+        ll y = hrc[i].x;
+        for(;added < bottoms.size() and bottoms[added].first < y;added++)
+        {
+            count(bottoms[added].second, 1);
+        }
+        for(;removed < tops.size() and tops[removed].first < y;removed++)
+        {
+            count(tops[removed].second, -1);
+        }
+        size_t low = column[h_to_v[2*i]/2], high = column[h_to_v[2*i+1]/2];
+        if(high <= low+1)
+        {
+            continue;
+        }
+        int left = before(low+1);
+        int inside = before(high)-left;
+        for(int k=1;k<=inside;k++)
+        {
+            point p;
+            p.x = xs[kth(left+k)];
+            p.y = y;
+            crossings.push_back({p, (left+k-1)%2 == 1});
+        }
+    }
+    return crossings;
+}
+
+/*! Cuts sorted contours at the points where they cross others
+    \param segments the contours, sorted
+    \param cuts the crossings on them, as (fixed coordinate, other coordinate) pairs sorted the same way
+    \return The pieces, sorted
+*/
+vector<line_segment> cut_contours(const vector<line_segment>& segments, const vector<pair<ll,ll>>& cuts)
+{
+    vector<line_segment> pieces;
+    pieces.reserve(segments.size()+cuts.size());
+    size_t c = 0;
+    for(auto s : segments)
+    {
+        while(c < cuts.size() and (cuts[c].first < s.x or (cuts[c].first == s.x and cuts[c].second < s.inter.top)))
+        {
+            line_segment lower = s;
+            lower.inter.top = cuts[c].second;
+            pieces.push_back(lower);
+            s.inter.bottom = cuts[c].second;
+            c++;
+        }
+        pieces.push_back(s);
+    }
+    return pieces;
+}
+
+bool assemble_polygons(const vector<line_segment>& horizontal, const vector<line_segment>& vertical, vector<contour_polygon>& polygons)
+{
+    STATS_TIMER(T_POLYGONS);
+    polygons.clear();
+    if(vertical.size() != horizontal.size())
+    {
+        return false;
+    }
+    //rings turn at every crossing: each pair of arms kept together wraps one of the covered quadrants, so parts of the union touching at a corner become rings of their own.
+    //Crossings are rare, so the contours are paired as they are first and only cut and paired again if there are any
+    vector<uint32_t> h_to_v, v_to_h;
+    if(not match_corners(horizontal, vertical, {}, h_to_v, v_to_h))
+    {
+        return false;
+    }
+    vector<pair<point,bool>> crossings = contour_crossings(horizontal, vertical, h_to_v);
+    vector<line_segment> cut_horizontal, cut_vertical;
+    if(not crossings.empty())
+    {
+        vector<pair<ll,ll>> on_horizontal, on_vertical;
+        for(auto& c : crossings)
+        {
+            on_horizontal.push_back({c.first.y, c.first.x});
+            on_vertical.push_back({c.first.x, c.first.y});
+        }
+        sort(on_vertical.begin(), on_vertical.end());
+        cut_horizontal = cut_contours(horizontal, on_horizontal);
+        cut_vertical = cut_contours(vertical, on_vertical);
+        if(not match_corners(cut_horizontal, cut_vertical, crossings, h_to_v, v_to_h))
+        {
+            return false;
+        }
+    }
+    const vector<line_segment>& hrc = crossings.empty() ? horizontal : cut_horizontal;
+    size_t corners = 2*hrc.size();
+    auto h_corner = [&](size_t c) { point p; p.x = c&1 ? hrc[c/2].inter.top : hrc[c/2].inter.bottom; p.y = hrc[c/2].x; return p; };
+    auto before = [](const point& a, const point& b) { return a.x < b.x or (a.x == b.x and a.y < b.y); };
+
+    //rows are the gaps between the heights of horizontal contours, numbered from the bottom
+    vector<ll> ys;
+    vector<uint32_t> h_row(hrc.size());
+    for(size_t h=0;h<hrc.size();h++)
+    {
+        if(ys.empty() or ys.back() != hrc[h].x)
+        {
+            ys.push_back(hrc[h].x);
+        }
+        h_row[h] = ys.size()-1;
+    }
+    size_t rows = ys.size();
+
+    //walk every ring, alternating horizontal and vertical contours, and note how it was traversed and its vertical sides
+    typedef struct side
+    {
+        ll x;
+        uint32_t bottom, top, ring;
+        bool up;
+    }side;
+    vector<side> sides;
+    sides.reserve(corners/2);
+    vector<char> seen(hrc.size(), 0);
+    vector<bool> counterclockwise;
+    for(size_t h=0;h<hrc.size();h++)
+    {
+        if(seen[h])
+        {
+            continue;
+        }
+        contour_polygon ring;
+        size_t c = 2*h;
+        do
+        {
+            if(seen[c/2])
+            {
+                return false;
+            }
+            seen[c/2] = 1;
+            ring.vertices.push_back(h_corner(c));
+            ring.vertices.push_back(h_corner(c^1));
+            size_t next = v_to_h[h_to_v[c^1]^1];
+            uint32_t from = h_row[c/2], to = h_row[next/2];
+            sides.push_back({ring.vertices.back().x, min(from, to), max(from, to), uint32_t(polygons.size()), to > from});
+            c = next;
+        }while(c != 2*h);
+        //start every ring at its lowest corner on its leftmost side. Nothing of the ring lies left of or below that corner, so the ring leaves it either to the right, going counterclockwise, or upwards, going clockwise
+        rotate(ring.vertices.begin(), min_element(ring.vertices.begin(), ring.vertices.end(), before), ring.vertices.end());
+        counterclockwise.push_back(ring.vertices[1].x > ring.vertices[0].x);
+        polygons.push_back(move(ring));
+    }
+
+    //a ring lies in the ring whose vertical side is met first by a ray going left from its first corner, if the ray enters that ring there, and next to it otherwise.
+    //The sides are swept from left to right, each painting its rows with its index in a segment tree; later sides lie further right, so the largest index on the way up from a row is the side last seen there
+    sort(sides.begin(), sides.end(), [](const side& a, const side& b) { return a.x < b.x; });
+    vector<uint32_t> order(polygons.size());
+    iota(order.begin(), order.end(), 0);
+    sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return polygons[a].vertices[0].x < polygons[b].vertices[0].x; });
+    vector<ll> painted(2*rows, -1);
+    size_t next_side = 0;
+    for(uint32_t r : order)
+    {
+        const point& corner = polygons[r].vertices[0];
+        while(next_side < sides.size() and sides[next_side].x < corner.x)
+        {
+            for(size_t low=sides[next_side].bottom+rows, high=sides[next_side].top+rows;low<high;low/=2, high/=2)
+            {
+                if(low&1)
+                {
+                    painted[low++] = next_side;
+                }
+                if(high&1)
+                {
+                    painted[--high] = next_side;
+                }
+            }
+            next_side++;
+        }
+        ll met = -1;
+        for(size_t at=(lower_bound(ys.begin(), ys.end(), corner.y)-ys.begin())+rows;at>0;at/=2)
+        {
+            met = max(met, painted[at]);
+        }
+        if(met < 0)
+        {
+            continue;
+        }
+        const side& f = sides[met];
+        contour_polygon& around = polygons[f.ring];
+        //inside a ring traversed counterclockwise lies left of the direction of travel, so right of a side going down
+        if(f.up != counterclockwise[f.ring])
+        {
+            polygons[r].parent = f.ring;
+            polygons[r].depth = around.depth+1;
+        }
+        else
+        {
+            polygons[r].parent = around.parent;
+            polygons[r].depth = around.depth;
+        }
+    }
+    for(size_t r=0;r<polygons.size();r++)
+    {
+        if(counterclockwise[r] != (polygons[r].depth%2 == 0))
+        {
+            reverse(polygons[r].vertices.begin()+1, polygons[r].vertices.end());
+        }
+    }
+    return true;
+}
+
+bool compare_contours(const char* what, const vector<line_segment>& a, const vector<line_segment>& b)
+{
+    vector<line_segment> only_a, only_b;
+    std::set_difference(a.begin(), a.end(), b.begin(), b.end(), back_inserter(only_a));
+    std::set_difference(b.begin(), b.end(), a.begin(), a.end(), back_inserter(only_b));
+    if(only_a.empty() and only_b.empty())
+    {
+        return true;
+    }
+    cerr << what << " contours differ: " << only_a.size() << " only in the selected engine, " << only_b.size() << " only in the other\n";
+    if(!only_a.empty())
+    {
+        cerr << "  first: " << only_a[0].x << " [" << only_a[0].inter.bottom << ", " << only_a[0].inter.top << "]\n";
+    }
+    if(!only_b.empty())
+    {
+        cerr << "  first missing: " << only_b[0].x << " [" << only_b[0].inter.bottom << ", " << only_b[0].inter.top << "]\n";
+    }
+    return false;
+}
+
+bool consistent_contours(const vector<line_segment>& hrc, const vector<line_segment>& vrc)
+{
+    //corners as (x, y), from both directions
+    vector<pair<ll,ll>> h, v;
+    h.reserve(2*hrc.size());
+    v.reserve(2*vrc.size());
+    for(const line_segment& s : hrc)
+    {
+        h.push_back({s.inter.bottom, s.x});
+        h.push_back({s.inter.top, s.x});
+    }
+    for(const line_segment& s : vrc)
+    {
+        v.push_back({s.x, s.inter.bottom});
+        v.push_back({s.x, s.inter.top});
+    }
+    sort(h.begin(), h.end());
+    sort(v.begin(), v.end());
+    //maximal segments never share an end with another segment of the same direction
+    if(adjacent_find(h.begin(), h.end()) != h.end() or adjacent_find(v.begin(), v.end()) != v.end())
+    {
+        cerr << "contours are inconsistent: two segments of the same direction share an end\n";
+        return false;
+    }
+    auto diff = std::mismatch(h.begin(), h.end(), v.begin(), v.end());
+    if(diff.first != h.end() or diff.second != v.end())
+    {
+        bool horizontal = diff.second == v.end() or (diff.first != h.end() and *diff.first < *diff.second);
+        const pair<ll,ll>& corner = horizontal ? *diff.first : *diff.second;
+        cerr << "contours are inconsistent: (" << corner.first << ", " << corner.second << ") ends a " << (horizontal ? "horizontal" : "vertical") << " contour only\n";
+        return false;
+    }
+    return true;
+}
+/*! Reads one optionally signed decimal integer, skipping the whitespace in front of it
+    \param p cursor into the text, left just past the integer
+    \param end end of the text
+    \param value receives the integer
+    \return false if the text ends, something other than an integer follows or the integer does not fit in 64 bits
+*/
+inline bool parse_integer(const char*& p, const char* end, ll& value)
+{
+    while(p < end and (*p == ' ' or *p == '\n' or *p == '\t' or *p == '\r'))
+    {
+        p++;
+    }
+    bool negative = false;
+    if(p < end and (*p == '-' or *p == '+'))
+    {
+        negative = *p == '-';
+        p++;
+    }
+    const char* digits = p;
+    unsigned long long v = 0;
+    //the magnitude of the most negative value is one more than that of the most positive one
+    const unsigned long long limit = negative ? (unsigned long long)LLONG_MAX+1 : (unsigned long long)LLONG_MAX;
+    while(p < end and (unsigned)(*p-'0') < 10)
+    {
+        unsigned digit = (unsigned)(*p-'0');
+        if(v > (limit-digit)/10)
+        {
+            return false;
+        }
+        v = v*10 + digit;
+        p++;
+    }
+    value = negative ? (ll)(0-v) : (ll)v;
+    return p != digits;
+}
+
+///Receives the rectangles of an input a batch at a time; it may take the contents of the batch
+typedef function<void(vector<rectangle>& batch)> rectangle_consumer;
+
+/*! Parses the text input format: a count n followed by n lines of x1 x2 y1 y2
+    \param p start of the text; left just past the last rectangle, where another set may begin
+    \param end end of the text
+    \param batch number of rectangles handed to consume at once; only the last batch may be smaller
+    \param consume receives the rectangles, numbered in input order
+    \return false, after reporting on cerr, if the text is malformed or shorter than announced
+*/
+bool parse_text_rectangles(const char*& p, const char* end, size_t batch, const rectangle_consumer& consume)
+{
+    ll n = 0;
+    if(not parse_integer(p, end, n) or n < 0)
+    {
+        cerr << "input: expected the number of rectangles\n";
+        return false;
+    }
+    //every rectangle needs at least eight characters, so a bogus count cannot reserve more than the text could hold
+    vector<rectangle> rects;
+    rects.reserve(min<size_t>(min<size_t>(n, (end-p)/8+1), batch));
+    ll v[4];
+    for(ll i=0;i<n;i++)
+    {
+        for(int k=0;k<4;k++)
+        {
+            if(not parse_integer(p, end, v[k]))
+            {
+                cerr << "input: rectangle " << i << " of " << n << " is missing or malformed\n";
+                return false;
+            }
+        }
+        rectangle r;
+        r.x_int.bottom = v[0];
+        r.x_int.top = v[1];
+        r.y_int.bottom = v[2];
+        r.y_int.top = v[3];
+        r.id = i;
+        rects.push_back(r);
+        if(rects.size() == batch)
+        {
+            consume(rects);
+            rects.clear();
+        }
+    }
+    if(not rects.empty())
+    {
+        consume(rects);
+    }
+    return true;
+}
+
+///Global variable to store the magic bytes that open a binary rectangle file
+const char BINARY_MAGIC[8] = {'C','O','N','T','R','E','C','T'};
+///Global variable to store the version of the binary rectangle format written by write_binary_rectangles
+const uint32_t BINARY_VERSION = 1;
+///Size in bytes of the binary header: magic, version, encoding and rectangle count
+const size_t BINARY_HEADER = 24;
+
+/*! Parses the binary input format described by binary_encoding
+    \param p start of the file, at the magic bytes; left just past the last rectangle, where another set may begin
+    \param end end of the file
+    \param batch number of rectangles handed to consume at once; only the last batch may be smaller
+    \param consume receives the rectangles, numbered in file order
+    \return false, after reporting on cerr, if the header is unknown or the payload is shorter than it announces
+*/
+bool parse_binary_rectangles(const char*& p, const char* end, size_t batch, const rectangle_consumer& consume)
+{
+    uint64_t tag = 0, count = 0;
+    if(size_t(end-p) < BINARY_HEADER)
+    {
+        cerr << "input: truncated binary header\n";
+        return false;
+    }
+    //version and encoding are two 32 bit fields, read together as one little endian 64 bit word
+    memcpy(&tag, p+8, 8);
+    memcpy(&count, p+16, 8);
+    tag = byte_order_le(tag);
+    count = byte_order_le(count);
+    uint32_t version = uint32_t(tag), encoding = uint32_t(tag >> 32);
+    p += BINARY_HEADER;
+    if(version != BINARY_VERSION)
+    {
+        cerr << "input: unsupported binary version " << version << "\n";
+        return false;
+    }
+    vector<rectangle> rects;
+    //hands the filled part of rects on once it holds a whole batch, or once the input is done
+    auto deliver = [&](bool last)
+    {
+        if(rects.size() == batch or (last and not rects.empty()))
+        {
+            consume(rects);
+            rects.clear();
+        }
+    };
+    if(encoding == ENCODING_FIXED)
+    {
+        if(count > size_t(end-p)/32)
+        {
+            cerr << "input: binary payload does not hold " << count << " rectangles\n";
+            return false;
+        }
+        rects.reserve(min<size_t>(count, batch));
+        for(uint64_t i=0;i<count;i++,p+=32)
+        {
+            uint64_t v[4];
+            memcpy(v, p, 32);
+            rectangle r;
+            r.x_int.bottom = (ll)byte_order_le(v[0]);
+            r.x_int.top = (ll)byte_order_le(v[1]);
+            r.y_int.bottom = (ll)byte_order_le(v[2]);
+            r.y_int.top = (ll)byte_order_le(v[3]);
+            r.id = i;
+            rects.push_back(r);
+            deliver(false);
+        }
+        deliver(true);
+        return true;
+    }
+    if(encoding != ENCODING_DELTA)
+    {
+        cerr << "input: unknown binary encoding " << encoding << "\n";
+        return false;
+    }
+    //every varint takes at least one byte
+    if(count > size_t(end-p)/4)
+    {
+        cerr << "input: binary payload does not hold " << count << " rectangles\n";
+        return false;
+    }
+    rects.reserve(min<size_t>(count, batch));
+    ll previous[4] = {0,0,0,0};
+    for(uint64_t i=0;i<count;i++)
+    {
+        for(int k=0;k<4;k++)
+        {
+            uint64_t z = 0;
+            int shift = 0;
+            while(true)
+            {
+                //the tenth byte holds bit 63 alone and ends the varint
+                if(p == end or (shift == 63 and (*p & 0xfe)))
+                {
+                    cerr << "input: rectangle " << i << " of " << count << " is truncated or malformed\n";
+                    return false;
+                }
+                uint8_t byte = *p++;
+                z |= uint64_t(byte & 0x7f) << shift;
+                shift += 7;
+                if(not (byte & 0x80))
+                {
+                    break;
+                }
+            }
+            previous[k] = (ll)((uint64_t)previous[k] + ((z >> 1) ^ -(z & 1)));
+        }
+        rectangle r;
+        r.x_int.bottom = previous[0];
+        r.x_int.top = previous[1];
+        r.y_int.bottom = previous[2];
+        r.y_int.top = previous[3];
+        r.id = i;
+        rects.push_back(r);
+        deliver(false);
+    }
+    deliver(true);
+    return true;
+}
+
+/*! Parses rectangles in either input format, a batch at a time
+    \param p start of the input
+    \param end end of the input
+    \param batch number of rectangles handed to consume at once
+    \param consume receives the rectangles
+    \return false, after reporting on cerr, if the input is malformed; batches before the error have been consumed
+*/
+bool scan_rectangles(const char* p, const char* end, size_t batch, const rectangle_consumer& consume)
+{
+    if(size_t(end-p) >= sizeof(BINARY_MAGIC) and memcmp(p, BINARY_MAGIC, sizeof(BINARY_MAGIC)) == 0)
+    {
+        if(not parse_binary_rectangles(p, end, batch, consume))
+        {
+            return false;
+        }
+        if(p != end)
+        {
+            cerr << "input: " << end-p << " stray bytes after the last rectangle\n";
+            return false;
+        }
+        return true;
+    }
+    return parse_text_rectangles(p, end, batch, consume);
+}
+
+bool parse_rectangles(const char* p, const char* end, vector<rectangle>& rects)
+{
+    rects.clear();
+    //a single batch holds everything, so the parser's vector is taken over without copying
+    return scan_rectangles(p, end, SIZE_MAX, [&rects](vector<rectangle>& batch) { rects.swap(batch); });
+}
+
+bool parse_rectangle_sets(const char* p, const char* end, vector<vector<rectangle>>& sets)
+{
+    sets.clear();
+    while(true)
+    {
+        while(p < end and (*p == ' ' or *p == '\n' or *p == '\t' or *p == '\r'))
+        {
+            p++;
+        }
+        if(p == end)
+        {
+            return true;
+        }
+        sets.emplace_back();
+        vector<rectangle>& set = sets.back();
+        auto take = [&set](vector<rectangle>& batch) { set.swap(batch); };
+        bool binary = size_t(end-p) >= sizeof(BINARY_MAGIC) and memcmp(p, BINARY_MAGIC, sizeof(BINARY_MAGIC)) == 0;
+        if(not (binary ? parse_binary_rectangles(p, end, SIZE_MAX, take) : parse_text_rectangles(p, end, SIZE_MAX, take)))
+        {
+            cerr << "input: set " << sets.size()-1 << " is malformed\n";
+            return false;
+        }
+    }
+}
+
+///Brief description of mapped input
+///
+///Read only view of a whole input file. Regular files are memory mapped so parsing reads the page cache directly; pipes and terminals, which cannot be mapped, are read into an owned buffer instead
+class mapped_input
+{
+public:
+    mapped_input() = default;
+    mapped_input(const mapped_input&) = delete;
+    mapped_input& operator=(const mapped_input&) = delete;
+    ~mapped_input()
+    {
+        if(mapped)
+        {
+            munmap((void*)base, length);
+        }
+    }
+
+    /*! Maps or reads everything that is left in a file descriptor
+        \param fd descriptor to read; it is not closed
+        \return false, with errno set, if the descriptor cannot be read
+    */
+    bool open(int fd)
+    {
+        struct stat st;
+        if(fstat(fd, &st) == 0 and S_ISREG(st.st_mode) and st.st_size > 0)
+        {
+            void* m = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(m != MAP_FAILED)
+            {
+                madvise(m, st.st_size, MADV_SEQUENTIAL);
+                base = (const char*)m;
+                length = st.st_size;
+                mapped = true;
+                return true;
+            }
+        }
+        const size_t CHUNK = 1<<20;
+        while(true)
+        {
+            size_t used = buffer.size();
+            buffer.resize(used+CHUNK);
+            ssize_t got = read(fd, buffer.data()+used, CHUNK);
+            if(got < 0 and errno == EINTR)
+            {
+                got = 0;
+            }
+            else if(got <= 0)
+            {
+                buffer.resize(used);
+                if(got < 0)
+                {
+                    return false;
+                }
+                break;
+            }
+            buffer.resize(used+got);
+        }
+        base = buffer.data();
+        length = buffer.size();
+        return true;
+    }
+
+    const char* begin() const { return base; }
+    const char* end() const { return base+length; }
+
+private:
+    const char* base = NULL;
+    size_t length = 0;
+    bool mapped = false;
+    vector<char> buffer;
+};
+
+/*! Maps or reads a whole input file, or standard input
+    \param path file to read, or "-" for standard input
+    \param in receives the contents
+    \return false, after reporting on cerr, if the file cannot be read
+*/
+bool open_input(const string& path, mapped_input& in)
+{
+    int fd = path == "-" ? 0 : ::open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+    {
+        cerr << path << ": " << strerror(errno) << "\n";
+        return false;
+    }
+    bool ok = in.open(fd);
+    if(not ok)
+    {
+        cerr << path << ": " << strerror(errno) << "\n";
+    }
+    if(fd != 0)
+    {
+        close(fd);
+    }
+    return ok;
+}
+
+/*! Parses rectangles in either input format from a file, or from standard input, a batch at a time
+    \param path file to read, or "-" for standard input
+    \param batch number of rectangles handed to consume at once
+    \param consume receives the rectangles
+    \return false, after reporting on cerr, if the file cannot be read or is malformed
+*/
+bool scan_rectangle_file(const string& path, size_t batch, const rectangle_consumer& consume)
+{
+    mapped_input in;
+    return open_input(path, in) and scan_rectangles(in.begin(), in.end(), batch, consume);
+}
+
+bool load_rectangles(const string& path, vector<rectangle>& rects)
+{
+    rects.clear();
+    return scan_rectangle_file(path, SIZE_MAX, [&rects](vector<rectangle>& batch) { rects.swap(batch); });
+}
+
+bool load_rectangle_sets(const string& path, vector<vector<rectangle>>& sets)
+{
+    sets.clear();
+    mapped_input in;
+    return open_input(path, in) and parse_rectangle_sets(in.begin(), in.end(), sets);
+}
+
+bool write_binary_rectangles(const vector<rectangle>& rects, const string& path, binary_encoding encoding)
+{
+    string out(BINARY_MAGIC, sizeof(BINARY_MAGIC));
+    auto put64 = [&](uint64_t v)
+    {
+        v = byte_order_le(v);
+        out.append((const char*)&v, 8);
+    };
+    put64(uint64_t(BINARY_VERSION) | uint64_t(encoding) << 32);
+    put64(rects.size());
+    ll previous[4] = {0,0,0,0};
+    for(auto& r : rects)
+    {
+        ll v[4] = {r.x_int.bottom, r.x_int.top, r.y_int.bottom, r.y_int.top};
+        for(int k=0;k<4;k++)
+        {
+            if(encoding == ENCODING_FIXED)
+            {
+                put64(v[k]);
+                continue;
+            }
+            ll d = (ll)((uint64_t)v[k]-(uint64_t)previous[k]);
+            uint64_t z = ((uint64_t)d << 1) ^ (uint64_t)(d >> 63);
+            while(z >= 0x80)
+            {
+                out.push_back(char(z | 0x80));
+                z >>= 7;
+            }
+            out.push_back(char(z));
+            previous[k] = v[k];
+        }
+    }
+    ofstream file(path, ios::binary);
+    file.write(out.data(), out.size());
+    file.close();
+    if(not file)
+    {
+        cerr << path << ": cannot write\n";
+        return false;
+    }
+    return true;
+}
+
+output_writer::~output_writer()
+{
+    close();
+}
+
+bool output_writer::open(const string& path, bool async)
+{
+    name = path;
+    owned = path != "-";
+    fd = owned ? ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644) : 1;
+    if(fd < 0)
+    {
+        cerr << path << ": " << strerror(errno) << "\n";
+        return false;
+    }
+    failed = false;
+    done = false;
+    current.reserve(BUFFER_BYTES);
+    if(async)
+    {
+        worker = thread([this]() { drain(); });
+    }
+    return true;
+}
+
+void output_writer::write(const char* p, size_t n)
+{
+    while(current.size()+n > BUFFER_BYTES)
+    {
+        size_t room = BUFFER_BYTES-current.size();
+        current.append(p, room);
+        p += room;
+        n -= room;
+        hand_off();
+    }
+    current.append(p, n);
+}
+
+void output_writer::put(const char* text)
+{
+    write(text, strlen(text));
+}
+
+void output_writer::put(ll v)
+{
+    char digits[24];
+    char* end = digits+sizeof(digits);
+    char* p = end;
+    unsigned long long u = v < 0 ? 0ULL-(unsigned long long)v : (unsigned long long)v;
+    do
+    {
+        *--p = char('0'+u%10);
+        u /= 10;
+    }while(u);
+    if(v < 0)
+    {
+        *--p = '-';
+    }
+    write(p, end-p);
+}
+
+void output_writer::put_measure(measure_int v)
+{
+    char digits[40];
+    char* end = digits+sizeof(digits);
+    char* p = end;
+    do
+    {
+        *--p = char('0'+unsigned(v%10));
+        v /= 10;
+    }while(v);
+    write(p, end-p);
+}
+
+void output_writer::put_binary(uint64_t v)
+{
+    v = byte_order_le(v);
+    write((const char*)&v, 8);
+}
+
+bool output_writer::close()
+{
+    if(fd < 0)
+    {
+        return true;
+    }
+    if(not current.empty())
+    {
+        hand_off();
+    }
+    if(worker.joinable())
+    {
+        {
+            lock_guard<mutex> lock(m);
+            done = true;
+        }
+        ready.notify_all();
+        worker.join();
+    }
+    if(owned and ::close(fd) != 0)
+    {
+        fail(errno);
+    }
+    fd = -1;
+    if(failed)
+    {
+        cerr << name << ": " << strerror(error) << "\n";
+    }
+    return not failed;
+}
+
+void output_writer::hand_off()
+{
+    if(not worker.joinable())
+    {
+        write_all(current);
+        current.clear();
+        return;
+    }
+    string next;
+    {
+        unique_lock<mutex> lock(m);
+        room.wait(lock, [&]() { return queue.size() < MAX_QUEUED; });
+        queue.push_back(move(current));
+        if(not spare.empty())
+        {
+            next = move(spare.back());
+            spare.pop_back();
+        }
+    }
+    ready.notify_one();
+    current = move(next);
+    current.clear();
+    current.reserve(BUFFER_BYTES);
+}
+
+void output_writer::drain()
+{
+    unique_lock<mutex> lock(m);
+    while(true)
+    {
+        ready.wait(lock, [&]() { return done or not queue.empty(); });
+        if(queue.empty())
+        {
+            return;
+        }
+        string buffer = move(queue.front());
+        queue.pop_front();
+        lock.unlock();
+        room.notify_one();
+        write_all(buffer);
+        lock.lock();
+        spare.push_back(move(buffer));
+    }
+}
+
+void output_writer::write_all(const string& buffer)
+{
+    const char* p = buffer.data();
+    size_t n = buffer.size();
+    while(n > 0 and not failed)
+    {
+        ssize_t got = ::write(fd, p, n);
+        if(got < 0)
+        {
+            if(errno != EINTR)
+            {
+                fail(errno);
+            }
+            continue;
+        }
+        p += got;
+        n -= got;
+    }
+}
+
+void output_writer::fail(int e)
+{
+    if(not failed)
+    {
+        error = e;
+        failed = true;
+    }
+}
+
+/*! Writes one rectangle, or the frame, as a line of rectangles.csv
+    \param out writer receiving the text
+    \param r the rectangle
+*/
+inline void put_rectangle_csv(output_writer& out, const rectangle& r)
+{
+    out.put(r.x_int.bottom); out.put(", "); out.put(r.x_int.top); out.put(", "); out.put(r.y_int.bottom); out.put(", "); out.put(r.y_int.top); out.put("\n");
+}
+
+void write_rectangles_csv(output_writer& out, const vector<rectangle>& rects)
+{
+    STATS_TIMER(T_CSV_WRITER);
+    out.put("Rectangles\n");
+    put_rectangle_csv(out, findFrame(rects.data(), rects.size()));
+    for(auto& r : rects)
+    {
+        put_rectangle_csv(out, r);
+    }
+}
+
+void put_segment_csv(output_writer& out, const line_segment& ls, bool horizontal)
+{
+    if(horizontal)
+    {
+        out.put(ls.inter.bottom); out.put(", "); out.put(ls.x); out.put(", "); out.put(ls.inter.top); out.put(", "); out.put(ls.x); out.put("\n");
+    }
+    else
+    {
+        out.put(ls.x); out.put(", "); out.put(ls.inter.bottom); out.put(", "); out.put(ls.x); out.put(", "); out.put(ls.inter.top); out.put("\n");
+    }
+}
+
+void put_segment_text(output_writer& out, const line_segment& ls, bool horizontal)
+{
+    if(horizontal)
+    {
+        out.put(ls.inter.bottom); out.put(" "); out.put(ls.x); out.put("     "); out.put(ls.inter.top); out.put(" "); out.put(ls.x); out.put("\n");
+    }
+    else
+    {
+        out.put(ls.x); out.put(" "); out.put(ls.inter.bottom); out.put("     "); out.put(ls.x); out.put(" "); out.put(ls.inter.top); out.put("\n");
+    }
+}
+
+void write_contours_csv(output_writer& out, const vector<line_segment>& hrc, const vector<line_segment>& vrc)
+{
+    STATS_TIMER(T_CSV_WRITER);
+    out.put("Contours\n");
+    for(auto& ls : hrc)
+    {
+        put_segment_csv(out, ls, true);
+    }
+    for(auto& ls : vrc)
+    {
+        put_segment_csv(out, ls, false);
+    }
+}
+
+void write_contours_text(output_writer& out, const vector<line_segment>& hrc, const vector<line_segment>& vrc)
+{
+    STATS_TIMER(T_OUTPUT);
+    out.put("Horizontal Contours\n");
+    for(auto& ls : hrc)
+    {
+        put_segment_text(out, ls, true);
+    }
+    out.put("Vertical Contours\n");
+    for(auto& ls : vrc)
+    {
+        put_segment_text(out, ls, false);
+    }
+}
+
+void write_polygons_text(output_writer& out, const vector<contour_polygon>& polygons)
+{
+    STATS_TIMER(T_OUTPUT);
+    for(size_t r=0;r<polygons.size();r++)
+    {
+        const contour_polygon& p = polygons[r];
+        out.put("Polygon "); out.put((ll)r); out.put(p.depth%2 ? " hole " : " outer "); out.put(p.parent); out.put(" "); out.put((ll)p.vertices.size()); out.put("\n");
+        for(auto& v : p.vertices)
+        {
+            out.put(v.x); out.put(" "); out.put(v.y); out.put("\n");
+        }
+    }
+}
+
+///Global variable to store the magic bytes that open a binary contour file
+const char SEGMENTS_MAGIC[8] = {'C','O','N','T','S','E','G','S'};
+
+void write_contours_binary(output_writer& out, const vector<line_segment>& hrc, const vector<line_segment>& vrc)
+{
+    STATS_TIMER(T_OUTPUT);
+    out.write(SEGMENTS_MAGIC, sizeof(SEGMENTS_MAGIC));
+    out.put_binary(hrc.size());
+    out.put_binary(vrc.size());
+    for(const vector<line_segment>* segments : {&hrc, &vrc})
+    {
+        for(auto& ls : *segments)
+        {
+            out.put_binary(ls.x);
+            out.put_binary(ls.inter.bottom);
+            out.put_binary(ls.inter.top);
+        }
+    }
+}
+
+bool csv_writer(const vector<rectangle>& rects, const vector<line_segment>& hrc, const vector<line_segment>& vrc)
+{
+    output_writer rectangles_file, contours_file;
+    bool ok = rectangles_file.open("rectangles.csv", false);
+    if(ok)
+    {
+        write_rectangles_csv(rectangles_file, rects);
+        ok = rectangles_file.close();
+    }
+    if(contours_file.open("contours.csv", false))
+    {
+        write_contours_csv(contours_file, hrc, vrc);
+        return contours_file.close() and ok;
+    }
+    return false;
+}
+
+///Brief description of divide and conquer buffers
+///
+///What the divide and conquer keeps between computations for one coordinate type
+template<class C> struct dac_buffers
+{
+    ///Owner of the ctree nodes, reset at the start of every computation
+    unique_ptr<ctree_arena<C>> arena;
+    ///The vertical and horizontal edges of the rectangles
+    vector<basic_edge<C>> vertical, horizontal;
+
+    dac_buffers() : arena(new ctree_arena<C>()) {}
+
+    ///Frees everything, keeping an empty arena
+    void release()
+    {
+        arena.reset(new ctree_arena<C>());
+        vector<basic_edge<C>>().swap(vertical);
+        vector<basic_edge<C>>().swap(horizontal);
+    }
+};
+
+///Brief description of engine state
+///
+///Everything a contour engine keeps between computations
+struct contour_engine::engine_state
+{
+    ///Options the engine was created with
+    engine_options options;
+    ///Task pool started by the engine itself when more than one thread was asked for
+    unique_ptr<task_pool> own_pool;
+    ///options.par with that pool
+    parallel_run par;
+    ///Scratch buffers for the horizontal edges and contour pieces of the sweep, the divide and conquer on 32 and on 64 bits, and the coordinate ranks
+    vector<edge> horizontal;
+    dac_buffers<int32_t> narrow;
+    dac_buffers<ll> wide;
+    coordinate_ranks ranks;
+    vector<line_segment> pieces;
+    ///The same for the transposed rectangles, used only with options.transposed
+    dac_buffers<int32_t> narrow_transposed;
+    dac_buffers<ll> wide_transposed;
+    coordinate_ranks transposed_ranks;
+    ///The rectangles with positive width and height, which alone take part with options.transposed
+    vector<rectangle> with_area;
+    ///End points of the merged horizontal contours of the sweep
+    vector<pair<ll,ll>> points;
+    ///What the last computation did
+    engine_report report;
+
+    /*! Computes the contours of edges already made with the divide and conquer
+        \param buffers holds the edges and the arena
+        \param xlimits the width of the frame
+        \param ylimits the height of the frame
+        \param mapping the coordinates the edges stand for when they hold ranks, or NULL
+        \param horizontal receives the horizontal contours
+        \param vertical receives the vertical contours, unless NULL
+        \param stripes receives the number of final stripes
+        \param lap records the end of a phase
+        \return Number of distinct horizontal contour pieces before merging
+    */
+    template<class C, class F> size_t dac_contour(dac_buffers<C>& buffers, basic_interval<C> xlimits, basic_interval<C> ylimits, const coordinate_ranks* mapping, vector<line_segment>& horizontal, vector<line_segment>* vertical, size_t& stripes, F lap)
+    {
+        vector<stripe<C>> S = rectangle_DAC(buffers.vertical, xlimits, ylimits, *buffers.arena, par);
+        stripes = S.size();
+        lap("rectangle_DAC");
+        sort_edges(buffers.horizontal);
+        stripe_index<C> index(S);
+        size_t pieces = contour(buffers.horizontal, index, mapping, par, horizontal, vertical);
+        lap("contour");
+        return pieces;
+    }
+
+    /*! Runs the divide and conquer on edges already made and, with options.transposed, at the same time on the transposed edges
+        \param buffers holds the edges
+        \param transposed receives the transposed edges
+        \param xlimits the width of the frame
+        \param ylimits the height of the frame
+        \param mapping the coordinates the edges stand for when they hold ranks, or NULL
+        \param out receives the horizontal and vertical contours
+        \param lap records the end of a phase
+    */
+    template<class C, class F> void divide_and_conquer(dac_buffers<C>& buffers, dac_buffers<C>& transposed, basic_interval<C> xlimits, basic_interval<C> ylimits, const coordinate_ranks* mapping, contour_result& out, F lap)
+    {
+        if(not options.transposed)
+        {
+            report.pieces = dac_contour(buffers, xlimits, ylimits, mapping, out.horizontal, &out.vertical, report.stripes, lap);
+            report.ctree_nodes = buffers.arena->node_count();
+            return;
+        }
+        //swapping x and y turns the bottom and top edges into left and right edges, and the horizontal contours of the transposed rectangles into the vertical contours of the original ones
+        transpose_edges(buffers.horizontal, transposed.vertical);
+        transpose_edges(buffers.vertical, transposed.horizontal);
+        const coordinate_ranks* transposed_mapping = NULL;
+        if(mapping != NULL)
+        {
+            transposed_ranks.xs = mapping->ys;
+            transposed_ranks.ys = mapping->xs;
+            transposed_mapping = &transposed_ranks;
+        }
+        lap("transpose_edges");
+        size_t transposed_stripes = 0;
+        auto unlapped = [](const char*) {};
+        auto run_transposed = [&]()
+        {
+            dac_contour(transposed, ylimits, xlimits, transposed_mapping, out.vertical, (vector<line_segment>*)NULL, transposed_stripes, unlapped);
+        };
+        if(par.pool != NULL)
+        {
+            task_group group;
+            par.pool->spawn(group, run_transposed);
+            report.pieces = dac_contour(buffers, xlimits, ylimits, mapping, out.horizontal, (vector<line_segment>*)NULL, report.stripes, unlapped);
+            par.pool->wait(group);
+        }
+        else
+        {
+            report.pieces = dac_contour(buffers, xlimits, ylimits, mapping, out.horizontal, (vector<line_segment>*)NULL, report.stripes, unlapped);
+            run_transposed();
+        }
+        report.stripes += transposed_stripes;
+        report.ctree_nodes = buffers.arena->node_count()+transposed.arena->node_count();
+        lap("transposed_contour");
+    }
+};
+
+contour_engine::contour_engine(const engine_options& options) : state(new engine_state())
+{
+    state->options = options;
+    state->par = parallel_run(options.par);
+    if(options.threads > 1)
+    {
+        state->own_pool.reset(new task_pool(options.threads));
+        state->par.pool = state->own_pool.get();
+    }
+}
+
+contour_engine::~contour_engine() = default;
+
+bool contour_engine::compute(const rectangle* rects, size_t n, contour_result& out)
+{
+    if(not rectangles_fit(n, "contour engine"))
+    {
+        return false;
+    }
+    engine_state& st = *state;
+    engine_report& report = st.report;
+    report.stripes = 0;
+    report.ctree_nodes = 0;
+    report.pieces = 0;
+    report.phases.clear();
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    auto lap = [&](const char* phase)
+    {
+        chrono::steady_clock::time_point now = chrono::steady_clock::now();
+        report.phases.push_back({phase, chrono::duration<double>(now-start).count()});
+        start = now;
+    };
+
+    if(st.options.algorithm == ENGINE_SWEEP)
+    {
+        sweep_contour(rects, n, st.horizontal, st.pieces);
+        lap("sweep_contour");
+        report.pieces = st.pieces.size();
+        st.points.clear();
+        out.horizontal = merge_contours(st.pieces, st.points);
+        lap("merge_contours");
+        out.vertical = pair_vertical_contours(st.points);
+        lap("pair_vertical_contours");
+    }
+    else
+    {
+        st.narrow.arena->reset();
+        st.wide.arena->reset();
+        st.narrow_transposed.arena->reset();
+        st.wide_transposed.arena->reset();
+        if(st.options.transposed)
+        {
+            //a rectangle without area leaves ends of its own behind in either run, which the other run does not match
+            st.with_area.clear();
+            copy_if(rects, rects+n, back_inserter(st.with_area), [](const rectangle& r) { return r.x_int.bottom < r.x_int.top and r.y_int.bottom < r.y_int.top; });
+            rects = st.with_area.data();
+            n = st.with_area.size();
+        }
+        rectangle frame;
+        dac_coordinates coordinates = choose_coordinates(rects, n, frame);
+        if(coordinates == DAC_NARROW)
+        {
+            coordinate_edges(rects, n, st.narrow.vertical, st.narrow.horizontal);
+            lap("coordinate_edges");
+            basic_interval<int32_t> xlimits = {int32_t(frame.x_int.bottom), int32_t(frame.x_int.top)};
+            basic_interval<int32_t> ylimits = {int32_t(frame.y_int.bottom), int32_t(frame.y_int.top)};
+            st.divide_and_conquer(st.narrow, st.narrow_transposed, xlimits, ylimits, (const coordinate_ranks*)NULL, out, lap);
+        }
+        else if(coordinates == DAC_RANKED)
+        {
+            rank_coordinates(rects, n, st.ranks, st.narrow.vertical, st.narrow.horizontal, st.par);
+            lap("rank_coordinates");
+            //the frame lies one rank beyond the coordinates on every side
+            basic_interval<rank_t> xlimits = {-1, rank_t(st.ranks.xs.size())};
+            basic_interval<rank_t> ylimits = {-1, rank_t(st.ranks.ys.size())};
+            st.divide_and_conquer(st.narrow, st.narrow_transposed, xlimits, ylimits, &st.ranks, out, lap);
+        }
+        else
+        {
+            coordinate_edges(rects, n, st.wide.vertical, st.wide.horizontal);
+            lap("coordinate_edges");
+            st.divide_and_conquer(st.wide, st.wide_transposed, frame.x_int, frame.y_int, (const coordinate_ranks*)NULL, out, lap);
+        }
+    }
+    report.arena_bytes = st.narrow.arena->byte_count()+st.wide.arena->byte_count()+st.narrow_transposed.arena->byte_count()+st.wide_transposed.arena->byte_count();
+    out.polygons.clear();
+    if(st.options.polygons)
+    {
+        assemble_polygons(out.horizontal, out.vertical, out.polygons);
+        lap("assemble_polygons");
+    }
+    return true;
+}
+
+bool contour_engine::measure(const rectangle* rects, size_t n, union_measures& out)
+{
+    if(not rectangles_fit(n, "contour engine"))
+    {
+        return false;
+    }
+    engine_state& st = *state;
+    engine_report& report = st.report;
+    report.stripes = 0;
+    report.ctree_nodes = 0;
+    report.phases.clear();
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    sweep_measures(rects, n, st.horizontal, st.pieces, out);
+    report.phases.push_back({"sweep_measures", chrono::duration<double>(chrono::steady_clock::now()-start).count()});
+    report.pieces = 0;
+    return true;
+}
+
+contour_result contour_engine::compute(const vector<rectangle>& rects)
+{
+    contour_result out;
+    compute(rects.data(), rects.size(), out);
+    return out;
+}
+
+const engine_report& contour_engine::report() const
+{
+    return state->report;
+}
+
+const engine_options& contour_engine::options() const
+{
+    return state->options;
+}
+
+void contour_engine::release()
+{
+    vector<edge>().swap(state->horizontal);
+    state->narrow.release();
+    state->wide.release();
+    state->narrow_transposed.release();
+    state->wide_transposed.release();
+    vector<rectangle>().swap(state->with_area);
+    vector<ll>().swap(state->ranks.xs);
+    vector<ll>().swap(state->ranks.ys);
+    vector<ll>().swap(state->transposed_ranks.xs);
+    vector<ll>().swap(state->transposed_ranks.ys);
+    vector<line_segment>().swap(state->pieces);
+    vector<pair<ll,ll>>().swap(state->points);
+    state->report.arena_bytes = 0;
+}
+
+/*! Divides and rounds towards minus infinity
+    \param a dividend
+    \param b divisor, positive
+    \return The largest integer not above a/b
+*/
+inline ll floor_div(ll a, ll b)
+{
+    return a/b - (a%b != 0 and a < 0);
+}
+
+///Brief description of grid index
+///
+///Finds the boxes, identified by integer keys, that may meet a query box. The plane is cut into square cells and every box is listed in each cell it overlaps; boxes overlapping more than MAX_CELLS cells are kept in one separate list instead, which every query returns
+class grid_index
+{
+public:
+    ///Largest number of cells a box is listed in
+    static const ll MAX_CELLS = 256;
+
+    explicit grid_index(ll cell) : cell(max<ll>(cell,1)) {}
+
+    ///Lists the box x by y under key
+    void insert(ll key, interval x, interval y)
+    {
+        ll x0, x1, y0, y1;
+        if(not cell_range(x, y, x0, x1, y0, y1))
+        {
+            large.push_back(key);
+            return;
+        }
+        for(ll cx=x0;cx<=x1;cx++)
+        {
+            for(ll cy=y0;cy<=y1;cy++)
+            {
+                cells[{cx,cy}].push_back(key);
+            }
+        }
+    }
+
+    ///Removes the box x by y listed under key; the box must be the one given to insert
+    void erase(ll key, interval x, interval y)
+    {
+        ll x0, x1, y0, y1;
+        if(not cell_range(x, y, x0, x1, y0, y1))
+        {
+            remove_key(large, key);
+            return;
+        }
+        for(ll cx=x0;cx<=x1;cx++)
+        {
+            for(ll cy=y0;cy<=y1;cy++)
+            {
+                auto it = cells.find({cx,cy});
+                remove_key(it->second, key);
+                if(it->second.empty())
+                {
+                    cells.erase(it);
+                }
+            }
+        }
+    }
+
+    ///Replaces keys with the sorted, duplicate free keys of every box sharing a cell with the box x by y, which includes every box meeting it
+    void query(interval x, interval y, vector<ll>& keys) const
+    {
+        keys.assign(large.begin(), large.end());
+        ll x0 = floor_div(x.bottom, cell), x1 = floor_div(x.top, cell);
+        ll y0 = floor_div(y.bottom, cell), y1 = floor_div(y.top, cell);
+        //a query spanning more cells than are occupied scans the occupied cells instead
+        if(double(x1-x0+1)*double(y1-y0+1) <= double(cells.size()))
+        {
+            for(ll cx=x0;cx<=x1;cx++)
+            {
+                for(ll cy=y0;cy<=y1;cy++)
+                {
+                    auto it = cells.find({cx,cy});
+                    if(it != cells.end())
+                    {
+                        keys.insert(keys.end(), it->second.begin(), it->second.end());
+                    }
+                }
+            }
+        }
+        else
+        {
+            for(auto& c : cells)
+            {
+                if(c.first.first >= x0 and c.first.first <= x1 and c.first.second >= y0 and c.first.second <= y1)
+                {
+                    keys.insert(keys.end(), c.second.begin(), c.second.end());
+                }
+            }
+        }
+        sort(keys.begin(), keys.end());
+        keys.erase(unique(keys.begin(), keys.end()), keys.end());
+    }
+
+private:
+    ///Column and row of a cell
+    typedef pair<ll,ll> cell_id;
+
+    ///Brief description of cell hash
+    ///
+    ///Mixes column and row so that neighbouring cells land in different buckets
+    typedef struct cell_hash
+    {
+        size_t operator()(const cell_id& c) const
+        {
+            return hash<ll>()((ll)((unsigned long long)c.first*0x9E3779B97F4A7C15ULL) ^ c.second);
+        }
+    }cell_hash;
+
+    ///Finds the cells overlapped by the box x by y; returns false if there are more than MAX_CELLS of them
+    bool cell_range(interval x, interval y, ll& x0, ll& x1, ll& y0, ll& y1) const
+    {
+        x0 = floor_div(x.bottom, cell);
+        x1 = floor_div(x.top, cell);
+        y0 = floor_div(y.bottom, cell);
+        y1 = floor_div(y.top, cell);
+        return double(x1-x0+1)*double(y1-y0+1) <= double(MAX_CELLS);
+    }
+
+    ///Removes one occurrence of key from v, not keeping the order
+    static void remove_key(vector<ll>& v, ll key)
+    {
+        auto it = find(v.begin(), v.end(), key);
+        *it = v.back();
+        v.pop_back();
+    }
+
+    ///Side of a cell
+    ll cell;
+    ///Keys listed in every occupied cell
+    unordered_map<cell_id, vector<ll>, cell_hash> cells;
+    ///Keys of the boxes overlapping too many cells
+    vector<ll> large;
+};
+
+///Brief description of dynamic state
+///
+///Everything a dynamic contour keeps between updates
+struct dynamic_contour::dynamic_state
+{
+    explicit dynamic_state(ll cell) : rect_index(cell), horizontal_index(cell), vertical_index(cell), engine(sweep_options()) {}
+
+    ///The sweep has the smallest start up cost, which is what the small recomputations of an update need
+    static engine_options sweep_options()
+    {
+        engine_options options;
+        options.algorithm = ENGINE_SWEEP;
+        return options;
+    }
+
+    ///Adds a maximal horizontal segment under a fresh handle
+    void add_horizontal(const line_segment& s)
+    {
+        horizontal[next_handle] = s;
+        horizontal_index.insert(next_handle, s.inter, interval{s.x,s.x});
+        next_handle++;
+    }
+
+    ///Adds a maximal vertical segment under a fresh handle
+    void add_vertical(const line_segment& s)
+    {
+        vertical[next_handle] = s;
+        vertical_index.insert(next_handle, interval{s.x,s.x}, s.inter);
+        next_handle++;
+    }
+
+    ///The rectangles by ID, and the grid locating them
+    unordered_map<ll, rectangle> rects;
+    grid_index rect_index;
+    ///The current maximal segments by handle, and the grids locating them
+    unordered_map<ll, line_segment> horizontal, vertical;
+    grid_index horizontal_index, vertical_index;
+    ///Handle given to the next segment
+    ll next_handle = 0;
+    ///Engine and scratch buffers of the recomputations
+    contour_engine engine;
+    vector<rectangle> clipped;
+    contour_result local;
+    vector<ll> keys;
+};
+
+dynamic_contour::dynamic_contour(const vector<rectangle>& initial, ll cell)
+{
+    vector<rectangle> valid;
+    unordered_set<ll> seen;
+    double sides = 0;
+    for(const rectangle& r : initial)
+    {
+        if(r.x_int.bottom < r.x_int.top and r.y_int.bottom < r.y_int.top and seen.insert(r.id).second)
+        {
+            valid.push_back(r);
+            sides += double(r.x_int.top-r.x_int.bottom) + double(r.y_int.top-r.y_int.bottom);
+        }
+    }
+    if(cell <= 0)
+    {
+        cell = valid.empty() ? 1024 : max<ll>(ll(2*sides/valid.size()), 1);
+    }
+    state.reset(new dynamic_state(cell));
+    for(const rectangle& r : valid)
+    {
+        state->rects[r.id] = r;
+        state->rect_index.insert(r.id, r.x_int, r.y_int);
+    }
+    contour_result c = state->engine.compute(valid);
+    for(const line_segment& s : c.horizontal)
+    {
+        state->add_horizontal(s);
+    }
+    for(const line_segment& s : c.vertical)
+    {
+        state->add_vertical(s);
+    }
+}
+
+dynamic_contour::~dynamic_contour() = default;
+
+bool dynamic_contour::insert(const rectangle& r, contour_delta& delta)
+{
+    delta = contour_delta();
+    if(r.x_int.bottom >= r.x_int.top or r.y_int.bottom >= r.y_int.top or state->rects.count(r.id))
+    {
+        return false;
+    }
+    state->rects[r.id] = r;
+    state->rect_index.insert(r.id, r.x_int, r.y_int);
+    update(r, delta);
+    return true;
+}
+
+bool dynamic_contour::erase(ll id, contour_delta& delta)
+{
+    delta = contour_delta();
+    auto it = state->rects.find(id);
+    if(it == state->rects.end())
+    {
+        return false;
+    }
+    rectangle r = it->second;
+    state->rects.erase(it);
+    state->rect_index.erase(r.id, r.x_int, r.y_int);
+    update(r, delta);
+    return true;
+}
+
+size_t dynamic_contour::size() const
+{
+    return state->rects.size();
+}
+
+void dynamic_contour::contour(contour_result& out) const
+{
+    out.horizontal.clear();
+    out.vertical.clear();
+    for(auto& h : state->horizontal)
+    {
+        out.horizontal.push_back(h.second);
+    }
+    for(auto& v : state->vertical)
+    {
+        out.vertical.push_back(v.second);
+    }
+    sort(out.horizontal.begin(), out.horizontal.end());
+    sort(out.vertical.begin(), out.vertical.end());
+}
+
+/*! Joins the pieces lying on the same lines into maximal segments, merging pieces that overlap or touch
+    \param lines pieces by the fixed coordinate of their line
+    \param out receives the maximal segments, sorted
+*/
+void join_pieces(map<ll, vector<interval>>& lines, vector<line_segment>& out)
+{
+    out.clear();
+    for(auto& line : lines)
+    {
+        vector<interval>& pieces = line.second;
+        sort(pieces.begin(), pieces.end());
+        line_segment s;
+        s.x = line.first;
+        s.inter = pieces[0];
+        for(size_t k=1;k<pieces.size();k++)
+        {
+            if(pieces[k].bottom <= s.inter.top)
+            {
+                s.inter.top = max(s.inter.top, pieces[k].top);
+            }
+            else
+            {
+                out.push_back(s);
+                s.inter = pieces[k];
+            }
+        }
+        out.push_back(s);
+    }
+}
+
+/*! Turns the old and new segments of an update into its delta: segments present in both are dropped from both
+    \param removed the old segments, replaced by the ones that disappeared
+    \param added the new segments, replaced by the ones that appeared
+*/
+void segment_difference(vector<line_segment>& removed, vector<line_segment>& added)
+{
+    sort(removed.begin(), removed.end());
+    vector<line_segment> only_old, only_new;
+    std::set_difference(removed.begin(), removed.end(), added.begin(), added.end(), back_inserter(only_old));
+    std::set_difference(added.begin(), added.end(), removed.begin(), removed.end(), back_inserter(only_new));
+    removed.swap(only_old);
+    added.swap(only_new);
+}
+
+void dynamic_contour::update(const rectangle& w, contour_delta& delta)
+{
+    //the contour only changes inside the closed box W of w, so only the maximal segments meeting W are replaced
+    dynamic_state& st = *state;
+    interval wx = w.x_int, wy = w.y_int;
+    st.horizontal_index.query(wx, wy, st.keys);
+    for(ll key : st.keys)
+    {
+        auto it = st.horizontal.find(key);
+        const line_segment& s = it->second;
+        if(s.x >= wy.bottom and s.x <= wy.top and s.inter.bottom <= wx.top and s.inter.top >= wx.bottom)
+        {
+            delta.removed_horizontal.push_back(s);
+            st.horizontal_index.erase(key, s.inter, interval{s.x,s.x});
+            st.horizontal.erase(it);
+        }
+    }
+    st.vertical_index.query(wx, wy, st.keys);
+    for(ll key : st.keys)
+    {
+        auto it = st.vertical.find(key);
+        const line_segment& s = it->second;
+        if(s.x >= wx.bottom and s.x <= wx.top and s.inter.bottom <= wy.top and s.inter.top >= wy.bottom)
+        {
+            delta.removed_vertical.push_back(s);
+            st.vertical_index.erase(key, interval{s.x,s.x}, s.inter);
+            st.vertical.erase(it);
+        }
+    }
+
+    //clipping the rectangles to W grown by one unit keeps the contour inside W exact, as no coordinate lies strictly between W and the grown box
+    interval gx = {wx.bottom-1, wx.top+1}, gy = {wy.bottom-1, wy.top+1};
+    st.rect_index.query(gx, gy, st.keys);
+    st.clipped.clear();
+    for(ll key : st.keys)
+    {
+        const rectangle& r = st.rects[key];
+        if(r.x_int.bottom < gx.top and r.x_int.top > gx.bottom and r.y_int.bottom < gy.top and r.y_int.top > gy.bottom)
+        {
+            rectangle c;
+            c.x_int = {max(r.x_int.bottom, gx.bottom), min(r.x_int.top, gx.top)};
+            c.y_int = {max(r.y_int.bottom, gy.bottom), min(r.y_int.top, gy.top)};
+            c.id = key;
+            st.clipped.push_back(c);
+        }
+    }
+    st.engine.compute(st.clipped.data(), st.clipped.size(), st.local);
+
+    //new contour inside W, plus the unchanged parts of the replaced segments outside W, joined line by line
+    map<ll, vector<interval>> lines;
+    for(const line_segment& s : st.local.horizontal)
+    {
+        ll lo = max(s.inter.bottom, wx.bottom), hi = min(s.inter.top, wx.top);
+        if(s.x >= wy.bottom and s.x <= wy.top and lo < hi)
+        {
+            lines[s.x].push_back({lo,hi});
+        }
+    }
+    for(const line_segment& s : delta.removed_horizontal)
+    {
+        if(s.inter.bottom < wx.bottom)
+        {
+            lines[s.x].push_back({s.inter.bottom, wx.bottom});
+        }
+        if(s.inter.top > wx.top)
+        {
+            lines[s.x].push_back({wx.top, s.inter.top});
+        }
+    }
+    join_pieces(lines, delta.added_horizontal);
+    lines.clear();
+    for(const line_segment& s : st.local.vertical)
+    {
+        ll lo = max(s.inter.bottom, wy.bottom), hi = min(s.inter.top, wy.top);
+        if(s.x >= wx.bottom and s.x <= wx.top and lo < hi)
+        {
+            lines[s.x].push_back({lo,hi});
+        }
+    }
+    for(const line_segment& s : delta.removed_vertical)
+    {
+        if(s.inter.bottom < wy.bottom)
+        {
+            lines[s.x].push_back({s.inter.bottom, wy.bottom});
+        }
+        if(s.inter.top > wy.top)
+        {
+            lines[s.x].push_back({wy.top, s.inter.top});
+        }
+    }
+    join_pieces(lines, delta.added_vertical);
+
+    for(const line_segment& s : delta.added_horizontal)
+    {
+        st.add_horizontal(s);
+    }
+    for(const line_segment& s : delta.added_vertical)
+    {
+        st.add_vertical(s);
+    }
+    segment_difference(delta.removed_horizontal, delta.added_horizontal);
+    segment_difference(delta.removed_vertical, delta.added_vertical);
+}
+
+///Global variable to store the bytes one rectangle of a tile is assumed to take while the contour of the tile is computed: the rectangle, its edges, its share of the coverage tree and of the contour pieces and segments
+const size_t TILE_BYTES_PER_RECT = 512;
+///Global variable to store the number of rectangles the tiled passes read from the input at once
+const size_t TILE_INPUT_BATCH = 1<<16;
+///Global variable to store the number of spill files joined by one merge; more files are first merged in groups, so the open descriptors stay bounded
+const size_t TILE_MERGE_FANIN = 256;
+
+/*! Appends records to a file, creating it if needed
+    \param path the file
+    \param data first record
+    \param n number of records
+    \return false, after reporting on cerr, if the file cannot be written
+*/
+template<class T>
+bool append_records(const string& path, const T* data, size_t n)
+{
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0600);
+    if(fd < 0)
+    {
+        cerr << path << ": " << strerror(errno) << "\n";
+        return false;
+    }
+    const char* p = (const char*)data;
+    size_t left = n*sizeof(T);
+    while(left > 0)
+    {
+        ssize_t got = ::write(fd, p, left);
+        if(got < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            cerr << path << ": " << strerror(errno) << "\n";
+            close(fd);
+            return false;
+        }
+        p += got;
+        left -= got;
+    }
+    if(close(fd) != 0)
+    {
+        cerr << path << ": " << strerror(errno) << "\n";
+        return false;
+    }
+    return true;
+}
+
+///Brief description of record reader
+///
+///Reads a file of fixed size records back in order, through a buffer holding a bounded number of them
+template<class T>
+class record_reader
+{
+public:
+    record_reader() = default;
+    record_reader(const record_reader&) = delete;
+    record_reader& operator=(const record_reader&) = delete;
+    ~record_reader()
+    {
+        if(fd >= 0)
+        {
+            close(fd);
+        }
+    }
+
+    /*! Opens a file written by append_records
+        \param path the file
+        \param records number of records the buffer holds
+        \return false, after reporting on cerr, if the file cannot be opened
+    */
+    bool open(const string& path, size_t records)
+    {
+        name = path;
+        fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0)
+        {
+            cerr << path << ": " << strerror(errno) << "\n";
+            return false;
+        }
+        buffer.resize(max<size_t>(records, 1));
+        return true;
+    }
+
+    /*! Reads the next record
+        \param out receives the record
+        \return false at the end of the file, or after a read error, see failed
+    */
+    bool next(T& out)
+    {
+        if(pos == filled and not refill())
+        {
+            return false;
+        }
+        out = buffer[pos++];
+        return true;
+    }
+
+    ///Whether reading stopped on an error rather than at the end of the file
+    bool failed = false;
+
+private:
+    /*! Reads the next buffer full of records
+        \return false if nothing was left
+    */
+    bool refill()
+    {
+        char* p = (char*)buffer.data();
+        size_t want = buffer.size()*sizeof(T), got = 0;
+        while(got < want)
+        {
+            ssize_t r = read(fd, p+got, want-got);
+            if(r < 0 and errno == EINTR)
+            {
+                continue;
+            }
+            if(r <= 0)
+            {
+                if(r < 0 or got%sizeof(T) != 0)
+                {
+                    cerr << name << ": " << (r < 0 ? strerror(errno) : "truncated record") << "\n";
+                    failed = true;
+                }
+                break;
+            }
+            got += r;
+        }
+        pos = 0;
+        filled = got/sizeof(T);
+        return filled > 0 and not failed;
+    }
+
+    string name;
+    int fd = -1;
+    vector<T> buffer;
+    size_t pos = 0, filled = 0;
+};
+
+/*! Computes the frame and the number of the rectangles in a file, reading it a batch at a time
+    \param path the file
+    \param frame receives the frame, as findFrame computes it for all the rectangles at once
+    \param n receives the number of rectangles
+    \return false, after reporting on cerr, if the file cannot be read or is malformed
+*/
+bool scan_frame(const string& path, rectangle& frame, size_t& n)
+{
+    n = 0;
+    frame = findFrame(NULL, 0);
+    return scan_rectangle_file(path, TILE_INPUT_BATCH, [&](vector<rectangle>& batch)
+    {
+        rectangle f = findFrame(batch.data(), batch.size());
+        if(n == 0)
+        {
+            frame = f;
+        }
+        frame.x_int.bottom = min(frame.x_int.bottom, f.x_int.bottom);
+        frame.x_int.top = max(frame.x_int.top, f.x_int.top);
+        frame.y_int.bottom = min(frame.y_int.bottom, f.y_int.bottom);
+        frame.y_int.top = max(frame.y_int.top, f.y_int.top);
+        n += batch.size();
+    });
+}
+
+bool write_rectangles_csv(output_writer& out, const string& path)
+{
+    rectangle frame;
+    size_t n;
+    if(not scan_frame(path, frame, n))
+    {
+        return false;
+    }
+    STATS_TIMER(T_CSV_WRITER);
+    out.put("Rectangles\n");
+    put_rectangle_csv(out, frame);
+    return scan_rectangle_file(path, TILE_INPUT_BATCH, [&out](vector<rectangle>& batch)
+    {
+        for(auto& r : batch)
+        {
+            put_rectangle_csv(out, r);
+        }
+    });
+}
+
+/*! Clips sorted contour segments to a closed box, dropping what is left without length; the pieces stay sorted, since segments on one line are disjoint
+    \param segments the segments, replaced by the pieces
+    \param line range of the fixed coordinate inside the box
+    \param along range of the other coordinate inside the box
+*/
+void clip_pieces(vector<line_segment>& segments, const interval& line, const interval& along)
+{
+    size_t kept = 0;
+    for(auto& s : segments)
+    {
+        line_segment c = s;
+        c.inter.bottom = max(s.inter.bottom, along.bottom);
+        c.inter.top = min(s.inter.top, along.top);
+        if(s.x >= line.bottom and s.x <= line.top and c.inter.bottom < c.inter.top)
+        {
+            segments[kept++] = c;
+        }
+    }
+    segments.resize(kept);
+}
+
+///Yields the next piece of a sorted source of contour pieces, or false once the source is exhausted
+typedef function<bool(line_segment& piece)> piece_source;
+
+/*! Merges sorted sources of contour pieces that were clipped to neighbouring boxes, joining the pieces on one line that overlap or touch, which are the parts of one segment cut at a seam
+    \param sources the sources, each sorted
+    \param emit receives the joined segments in order
+*/
+void stitch_pieces(vector<piece_source>& sources, const function<void(const line_segment&)>& emit)
+{
+    auto later = [](const pair<line_segment,size_t>& a, const pair<line_segment,size_t>& b) { return b.first < a.first; };
+    priority_queue<pair<line_segment,size_t>, vector<pair<line_segment,size_t>>, decltype(later)> heap(later);
+    line_segment s;
+    for(size_t i=0;i<sources.size();i++)
+    {
+        if(sources[i](s))
+        {
+            heap.push({s, i});
+        }
+    }
+    bool have = false;
+    line_segment run;
+    while(not heap.empty())
+    {
+        pair<line_segment,size_t> top = heap.top();
+        heap.pop();
+        if(sources[top.second](s))
+        {
+            heap.push({s, top.second});
+        }
+        const line_segment& c = top.first;
+        if(have and c.x == run.x and c.inter.bottom <= run.inter.top)
+        {
+            run.inter.top = max(run.inter.top, c.inter.top);
+            continue;
+        }
+        if(have)
+        {
+            emit(run);
+        }
+        run = c;
+        have = true;
+    }
+    if(have)
+    {
+        emit(run);
+    }
+}
+
+///Brief description of tile structure
+///
+///One box of a tiled computation. Its contour is computed from the rectangles clipped to the box grown by one unit on every side: they agree with the input on an open neighbourhood of the closed box, and the contour inside the closed box depends on nothing else
+typedef struct tile
+{
+    ///Closed x-range of the tile
+    interval x;
+    ///Closed y-range of the tile
+    interval y;
+    ///Temporary file holding the clipped rectangles
+    string path;
+    ///Number of clipped rectangles, in the file and in pending together
+    size_t count = 0;
+    ///Clipped rectangles not yet appended to the file
+    vector<rectangle> pending;
+    ///Set once a single rectangle covers the grown box: the tile then has no contour and drops its rectangles
+    bool covered = false;
+    ///Number of rectangles of the tile this one was split from, 0 for a tile of the first grid
+    size_t parent_count = 0;
+}tile;
+
+///Brief description of tiled run
+///
+///State of one call of tiled_contour: the temporary directory and everything written to it
+struct tiled_run
+{
+    tiled_options options;
+    tiled_report report;
+    ///Temporary directory, removed with its files when the run ends
+    string dir;
+    ///Number of temporary file names handed out so far
+    size_t files = 0;
+    ///Rectangles a tile may hold before it is split
+    size_t tile_rects = 0;
+
+    ~tiled_run()
+    {
+        if(dir.empty())
+        {
+            return;
+        }
+        for(size_t f=0;f<files;f++)
+        {
+            unlink(file_name(f).c_str());
+        }
+        rmdir(dir.c_str());
+    }
+
+    /*! Creates the temporary directory
+        \return false, after reporting on cerr, if it cannot be created
+    */
+    bool open()
+    {
+        string base = options.temp_dir;
+        if(base.empty())
+        {
+            const char* env = getenv("TMPDIR");
+            base = env and *env ? env : "/tmp";
+        }
+        string pattern = base + "/contours-XXXXXX";
+        if(mkdtemp(&pattern[0]) == NULL)
+        {
+            cerr << base << ": " << strerror(errno) << "\n";
+            return false;
+        }
+        dir = pattern;
+        return true;
+    }
+
+    ///Name of the temporary file with number f
+    string file_name(size_t f) const
+    {
+        return dir + "/" + to_string(f);
+    }
+
+    ///Name of a new temporary file
+    string new_file()
+    {
+        return file_name(files++);
+    }
+
+    /*! Appends records to a temporary file and counts the bytes spilled
+        \param path the file
+        \param records the records
+        \return false, after reporting on cerr, if the file cannot be written
+    */
+    template<class T>
+    bool spill(const string& path, const vector<T>& records)
+    {
+        report.spill_bytes += records.size()*sizeof(T);
+        return append_records(path, records.data(), records.size());
+    }
+
+    /*! Moves the pending rectangles of a tile to its file
+        \param t the tile
+        \return false, after reporting on cerr, if the file cannot be written
+    */
+    bool flush(tile& t)
+    {
+        bool ok = t.pending.empty() or spill(t.path, t.pending);
+        t.pending.clear();
+        return ok;
+    }
+
+    /*! Clips rectangles to the grown boxes of a grid of tiles and buffers them with every tile they reach
+        \param batch the rectangles
+        \param xb the kx+1 x-coordinates separating the columns of the grid
+        \param yb the ky+1 y-coordinates separating the rows
+        \param tiles the kx*ky tiles, row by row
+        \param flush_at pending rectangles a tile holds before appending them to its file
+        \return false, after reporting on cerr, if a file cannot be written
+    */
+    bool distribute(const vector<rectangle>& batch, const vector<ll>& xb, const vector<ll>& yb, vector<tile>& tiles, size_t flush_at)
+    {
+        size_t kx = xb.size()-1;
+        for(auto& r : batch)
+        {
+            //as in dynamic_contour only rectangles with area take part; the contour the engine makes of degenerate ones depends on the whole input and cannot be assembled from tiles
+            if(r.x_int.bottom >= r.x_int.top or r.y_int.bottom >= r.y_int.top)
+            {
+                continue;
+            }
+            //column i is reached when xb[i]-1 < x2 and x1 < xb[i+1]+1
+            size_t i0 = upper_bound(xb.begin()+1, xb.end(), r.x_int.bottom-1)-(xb.begin()+1);
+            size_t i1 = upper_bound(xb.begin(), xb.end()-1, r.x_int.top)-xb.begin();
+            size_t j0 = upper_bound(yb.begin()+1, yb.end(), r.y_int.bottom-1)-(yb.begin()+1);
+            size_t j1 = upper_bound(yb.begin(), yb.end()-1, r.y_int.top)-yb.begin();
+            for(size_t j=j0;j<j1;j++)
+            {
+                for(size_t i=i0;i<i1;i++)
+                {
+                    tile& t = tiles[j*kx+i];
+                    if(t.covered)
+                    {
+                        continue;
+                    }
+                    rectangle c = r;
+                    c.x_int.bottom = max(r.x_int.bottom, t.x.bottom-1);
+                    c.x_int.top = min(r.x_int.top, t.x.top+1);
+                    c.y_int.bottom = max(r.y_int.bottom, t.y.bottom-1);
+                    c.y_int.top = min(r.y_int.top, t.y.top+1);
+                    if(c.x_int.bottom == t.x.bottom-1 and c.x_int.top == t.x.top+1 and c.y_int.bottom == t.y.bottom-1 and c.y_int.top == t.y.top+1)
+                    {
+                        t.covered = true;
+                        t.count = 0;
+                        vector<rectangle>().swap(t.pending);
+                        unlink(t.path.c_str());
+                        continue;
+                    }
+                    t.pending.push_back(c);
+                    t.count++;
+                    if(t.pending.size() >= flush_at and not flush(t))
+                    {
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    /*! Makes the tiles of a grid
+        \param xb the x-coordinates separating the columns
+        \param yb the y-coordinates separating the rows
+        \param parent_count rectangles of the tile the grid divides, 0 for the first grid
+        \return The tiles, row by row
+    */
+    vector<tile> make_grid(const vector<ll>& xb, const vector<ll>& yb, size_t parent_count)
+    {
+        vector<tile> tiles;
+        for(size_t j=0;j+1<yb.size();j++)
+        {
+            for(size_t i=0;i+1<xb.size();i++)
+            {
+                tile t;
+                t.x.bottom = xb[i];
+                t.x.top = xb[i+1];
+                t.y.bottom = yb[j];
+                t.y.top = yb[j+1];
+                t.path = new_file();
+                t.parent_count = parent_count;
+                tiles.push_back(move(t));
+            }
+        }
+        return tiles;
+    }
+
+    /*! Number of pending rectangles a tile of a grid holds before they are appended to its file, so all pending buffers together take a quarter of the budget
+        \param tiles number of tiles in the grid
+    */
+    size_t flush_threshold(size_t tiles) const
+    {
+        return min<size_t>(max<size_t>(options.memory_budget/4/tiles/sizeof(rectangle), 64), 1<<15);
+    }
+
+    /*! Splits a tile in four, moving its rectangles to the quarters
+        \param t the tile, whose file is removed
+        \param quarters receives the quarters
+        \return false, after reporting on cerr, if a file cannot be read or written
+    */
+    bool split(tile& t, vector<tile>& quarters)
+    {
+        ll xm = t.x.bottom+(t.x.top-t.x.bottom)/2, ym = t.y.bottom+(t.y.top-t.y.bottom)/2;
+        vector<ll> xb = {t.x.bottom, xm, t.x.top}, yb = {t.y.bottom, ym, t.y.top};
+        quarters = make_grid(xb, yb, t.count);
+        size_t flush_at = flush_threshold(4);
+        record_reader<rectangle> in;
+        if(not in.open(t.path, TILE_INPUT_BATCH))
+        {
+            return false;
+        }
+        vector<rectangle> batch;
+        rectangle r;
+        while(true)
+        {
+            bool more = in.next(r);
+            if(more)
+            {
+                batch.push_back(r);
+            }
+            if(batch.size() == TILE_INPUT_BATCH or (not more and not batch.empty()))
+            {
+                if(not distribute(batch, xb, yb, quarters, flush_at))
+                {
+                    return false;
+                }
+                batch.clear();
+            }
+            if(not more)
+            {
+                break;
+            }
+        }
+        unlink(t.path.c_str());
+        for(auto& q : quarters)
+        {
+            if(not flush(q))
+            {
+                return false;
+            }
+        }
+        report.splits++;
+        return not in.failed;
+    }
+
+    /*! Computes the contour of a tile and spills its pieces, clipped to the closed tile
+        \param t the tile, whose file is removed
+        \param engine engine computing the contour
+        \param horizontal_files receives the file of the horizontal pieces, if there are any
+        \param vertical_files receives the file of the vertical pieces, if there are any
+        \return false, after reporting on cerr, if a file cannot be read or written
+    */
+    bool solve(tile& t, contour_engine& engine, vector<string>& horizontal_files, vector<string>& vertical_files)
+    {
+        vector<rectangle> rects;
+        rects.reserve(t.count);
+        record_reader<rectangle> in;
+        if(not in.open(t.path, TILE_INPUT_BATCH))
+        {
+            return false;
+        }
+        rectangle r;
+        while(in.next(r))
+        {
+            rects.push_back(r);
+        }
+        unlink(t.path.c_str());
+        if(in.failed)
+        {
+            return false;
+        }
+        report.tiles++;
+        report.largest_tile = max(report.largest_tile, rects.size());
+        if(rects.size() > tile_rects)
+        {
+            report.over_budget_tiles++;
+        }
+        contour_result contours;
+        if(not engine.compute(rects.data(), rects.size(), contours))
+        {
+            return false;
+        }
+        vector<rectangle>().swap(rects);
+        auto clip = [&](vector<line_segment>& segments, const interval& line, const interval& along, vector<string>& files)
+        {
+            clip_pieces(segments, line, along);
+            if(segments.empty())
+            {
+                return true;
+            }
+            files.push_back(new_file());
+            return spill(files.back(), segments);
+        };
+        return clip(contours.horizontal, t.y, t.x, horizontal_files) and clip(contours.vertical, t.x, t.y, vertical_files);
+    }
+
+    /*! Merges sorted spill files of contour pieces, joining pieces on one line that overlap or touch
+        \param files the files, which are removed
+        \param emit receives the joined segments in order
+        \return false, after reporting on cerr, if a file cannot be read
+    */
+    bool merge(const vector<string>& files, const function<void(const line_segment&)>& emit)
+    {
+        size_t records = min<size_t>(max<size_t>(options.memory_budget/2/max<size_t>(files.size(), 1)/sizeof(line_segment), 64), 1<<16);
+        vector<unique_ptr<record_reader<line_segment>>> readers;
+        vector<piece_source> sources;
+        for(auto& f : files)
+        {
+            readers.emplace_back(new record_reader<line_segment>());
+            if(not readers.back()->open(f, records))
+            {
+                return false;
+            }
+            record_reader<line_segment>* reader = readers.back().get();
+            sources.push_back([reader](line_segment& s) { return reader->next(s); });
+        }
+        stitch_pieces(sources, emit);
+        bool ok = true;
+        for(size_t f=0;f<files.size();f++)
+        {
+            ok = ok and not readers[f]->failed;
+            unlink(files[f].c_str());
+        }
+        return ok;
+    }
+
+    /*! Merges spill files into at most TILE_MERGE_FANIN files, a group at a time
+        \param files the files; replaced by the merged ones
+        \return false, after reporting on cerr, if a file cannot be read or written
+    */
+    bool reduce(vector<string>& files)
+    {
+        while(files.size() > TILE_MERGE_FANIN)
+        {
+            vector<string> merged;
+            size_t records = min<size_t>(max<size_t>(options.memory_budget/4/sizeof(line_segment), 64), 1<<16);
+            for(size_t g=0;g<files.size();g+=TILE_MERGE_FANIN)
+            {
+                vector<string> group(files.begin()+g, files.begin()+min(files.size(), g+TILE_MERGE_FANIN));
+                merged.push_back(new_file());
+                vector<line_segment> out;
+                bool ok = true;
+                bool read = merge(group, [&](const line_segment& s)
+                {
+                    out.push_back(s);
+                    if(out.size() == records)
+                    {
+                        ok = ok and spill(merged.back(), out);
+                        out.clear();
+                    }
+                });
+                if(not read or not ok or not (out.empty() or spill(merged.back(), out)))
+                {
+                    return false;
+                }
+            }
+            files.swap(merged);
+        }
+        return true;
+    }
+};
+
+bool tiled_contour(const string& path, const tiled_options& options, const segment_sink& sink, tiled_report* report)
+{
+    if(path == "-")
+    {
+        cerr << "tiled contour: the input is read more than once and must be a file\n";
+        return false;
+    }
+    tiled_run run;
+    run.options = options;
+    run.options.memory_budget = max<size_t>(options.memory_budget, 1<<20);
+    run.tile_rects = run.options.memory_budget/TILE_BYTES_PER_RECT;
+    rectangle frame;
+    size_t n;
+    if(not scan_frame(path, frame, n))
+    {
+        return false;
+    }
+    if(frame_at_limits(frame))
+    {
+        cerr << "tiled contour: coordinates within 2 of the limits of 64 bits are not supported\n";
+        return false;
+    }
+    if(not run.open())
+    {
+        return false;
+    }
+    run.report.rectangles = n;
+
+    //a grid of about twice as many tiles as the budget demands leaves room for rectangles reaching several tiles
+    size_t wanted = (2*n+run.tile_rects-1)/run.tile_rects;
+    size_t k = max<size_t>(ceil(sqrt(double(wanted))), 1);
+    //a frame spanning the whole of ll is wider than ll can hold
+    __int128 width = (__int128)frame.x_int.top-frame.x_int.bottom, height = (__int128)frame.y_int.top-frame.y_int.bottom;
+    size_t kx = size_t(max<__int128>(min<__int128>(k, width), 1)), ky = size_t(max<__int128>(min<__int128>(k, height), 1));
+    vector<ll> xb(kx+1), yb(ky+1);
+    for(size_t i=0;i<=kx;i++)
+    {
+        xb[i] = ll(frame.x_int.bottom+width*i/kx);
+    }
+    for(size_t j=0;j<=ky;j++)
+    {
+        yb[j] = ll(frame.y_int.bottom+height*j/ky);
+    }
+    vector<tile> work = run.make_grid(xb, yb, 0);
+    size_t flush_at = run.flush_threshold(work.size());
+    bool ok = true;
+    ok = scan_rectangle_file(path, TILE_INPUT_BATCH, [&](vector<rectangle>& batch)
+    {
+        ok = ok and run.distribute(batch, xb, yb, work, flush_at);
+    }) and ok;
+    for(auto& t : work)
+    {
+        ok = ok and run.flush(t);
+        vector<rectangle>().swap(t.pending);
+    }
+    if(not ok)
+    {
+        return false;
+    }
+
+    engine_options sweep;
+    sweep.algorithm = ENGINE_SWEEP;
+    contour_engine engine(sweep);
+    vector<string> horizontal_files, vertical_files;
+    while(not work.empty())
+    {
+        tile t = move(work.back());
+        work.pop_back();
+        if(t.covered or t.count == 0)
+        {
+            run.report.covered_tiles += t.covered;
+            unlink(t.path.c_str());
+            continue;
+        }
+        //a split that leaves a quarter with most of the rectangles of its parent would only repeat itself
+        bool shrinking = t.parent_count == 0 or t.count <= t.parent_count/4*3;
+        if(t.count > run.tile_rects and shrinking and t.x.top-t.x.bottom >= 2 and t.y.top-t.y.bottom >= 2)
+        {
+            vector<tile> quarters;
+            if(not run.split(t, quarters))
+            {
+                return false;
+            }
+            for(auto& q : quarters)
+            {
+                work.push_back(move(q));
+            }
+            continue;
+        }
+        if(not run.solve(t, engine, horizontal_files, vertical_files))
+        {
+            return false;
+        }
+    }
+    engine.release();
+
+    if(not run.reduce(horizontal_files) or not run.reduce(vertical_files))
+    {
+        return false;
+    }
+    if(not run.merge(horizontal_files, [&sink](const line_segment& s) { sink(s, true); }))
+    {
+        return false;
+    }
+    if(not run.merge(vertical_files, [&sink](const line_segment& s) { sink(s, false); }))
+    {
+        return false;
+    }
+    if(report)
+    {
+        *report = run.report;
+    }
+    return true;
+}
+
+/*! Sends a whole buffer over a socket, retrying short and interrupted sends. A peer that went away is reported as an error rather than by SIGPIPE
+    \param fd the socket
+    \param data first byte
+    \param n number of bytes
+    \return false if the buffer could not be sent
+*/
+bool send_all(int fd, const void* data, size_t n)
+{
+    const char* p = (const char*)data;
+    while(n > 0)
+    {
+        ssize_t got = send(fd, p, n, MSG_NOSIGNAL);
+        if(got < 0 and errno == EINTR)
+        {
+            continue;
+        }
+        if(got <= 0)
+        {
+            return false;
+        }
+        p += got;
+        n -= got;
+    }
+    return true;
+}
+
+/*! Receives exactly n bytes from a socket
+    \param fd the socket
+    \param data receives the bytes
+    \param n number of bytes
+    \return false if the peer closed the socket or an error occurred first
+*/
+bool receive_all(int fd, void* data, size_t n)
+{
+    char* p = (char*)data;
+    while(n > 0)
+    {
+        ssize_t got = recv(fd, p, n, 0);
+        if(got < 0 and errno == EINTR)
+        {
+            continue;
+        }
+        if(got <= 0)
+        {
+            return false;
+        }
+        p += got;
+        n -= got;
+    }
+    return true;
+}
+
+/*! Sends a vector of plain records as its length followed by the records
+    \param fd the socket
+    \param v the records
+    \return false if the message could not be sent
+*/
+template<class T>
+bool send_records(int fd, const vector<T>& v)
+{
+    uint64_t n = v.size();
+    return send_all(fd, &n, sizeof(n)) and send_all(fd, v.data(), n*sizeof(T));
+}
+
+/*! Receives a vector sent by send_records
+    \param fd the socket
+    \param v receives the records
+    \return false if the message was cut short
+*/
+template<class T>
+bool receive_records(int fd, vector<T>& v)
+{
+    uint64_t n;
+    if(not receive_all(fd, &n, sizeof(n)))
+    {
+        return false;
+    }
+    v.resize(n);
+    return receive_all(fd, v.data(), n*sizeof(T));
+}
+
+/*! Body of a shard worker process: receives the rectangles of a shard, computes their contour and sends back the pieces inside the x-range of the shard, horizontal pieces first
+    \param fd socket to the coordinator
+    \param x closed x-range of the shard
+    \param options options of the engine computing the contour
+    \return The exit status of the worker
+*/
+int shard_worker(int fd, const interval& x, const engine_options& options)
+{
+    vector<rectangle> rects;
+    if(not receive_records(fd, rects))
+    {
+        return 1;
+    }
+    contour_engine engine(options);
+    contour_result contours;
+    if(not engine.compute(rects.data(), rects.size(), contours))
+    {
+        return 1;
+    }
+    vector<rectangle>().swap(rects);
+    interval everywhere;
+    everywhere.bottom = LLONG_MIN;
+    everywhere.top = LLONG_MAX;
+    clip_pieces(contours.horizontal, everywhere, x);
+    clip_pieces(contours.vertical, x, everywhere);
+    return send_records(fd, contours.horizontal) and send_records(fd, contours.vertical) ? 0 : 1;
+}
+
+bool sharded_contour(const vector<rectangle>& rects, const shard_options& options, contour_result& out, shard_report* report)
+{
+    if(not rectangles_fit(rects.size(), "sharded contour"))
+    {
+        return false;
+    }
+    //the shards split the vertical edges evenly, the cut stripes() makes at xm taken workers-1 times at once
+    rectangle frame = findFrame(rects.data(), rects.size());
+    if(frame_at_limits(frame))
+    {
+        cerr << "sharded contour: coordinates within 2 of the limits of 64 bits are not supported\n";
+        return false;
+    }
+    vector<ll> xs;
+    xs.reserve(2*rects.size());
+    for(auto& r : rects)
+    {
+        if(r.x_int.bottom < r.x_int.top and r.y_int.bottom < r.y_int.top)
+        {
+            xs.push_back(r.x_int.bottom);
+            xs.push_back(r.x_int.top);
+        }
+    }
+    size_t workers = max<size_t>(options.workers, 1);
+    vector<ll> xb = {frame.x_int.bottom};
+    for(size_t i=1;i<workers and not xs.empty();i++)
+    {
+        auto cut = xs.begin()+i*xs.size()/workers;
+        nth_element(xs.begin(), cut, xs.end());
+        if(*cut > xb.back() and *cut < frame.x_int.top)
+        {
+            xb.push_back(*cut);
+        }
+    }
+    xb.push_back(frame.x_int.top);
+    vector<ll>().swap(xs);
+    size_t shards = xb.size()-1;
+    engine_options worker_options = options.engine;
+    worker_options.threads = max<size_t>(options.engine.threads/shards, 1);
+
+    //every worker is started before any shard is built, so the workers do not inherit the shards
+    vector<int> sockets;
+    vector<pid_t> pids;
+    auto finish = [&]()
+    {
+        bool ok = true;
+        for(int fd : sockets)
+        {
+            close(fd);
+        }
+        for(pid_t pid : pids)
+        {
+            int status = 0;
+            while(waitpid(pid, &status, 0) < 0 and errno == EINTR)
+            {
+            }
+            ok = ok and WIFEXITED(status) and WEXITSTATUS(status) == 0;
+        }
+        return ok;
+    };
+    for(size_t i=0;i<shards;i++)
+    {
+        int sv[2];
+        if(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0)
+        {
+            cerr << "sharded contour: " << strerror(errno) << "\n";
+            finish();
+            return false;
+        }
+        pid_t pid = fork();
+        if(pid == 0)
+        {
+            close(sv[0]);
+            for(int fd : sockets)
+            {
+                close(fd);
+            }
+            interval x;
+            x.bottom = xb[i];
+            x.top = xb[i+1];
+            _exit(shard_worker(sv[1], x, worker_options));
+        }
+        close(sv[1]);
+        if(pid < 0)
+        {
+            cerr << "sharded contour: " << strerror(errno) << "\n";
+            close(sv[0]);
+            finish();
+            return false;
+        }
+        sockets.push_back(sv[0]);
+        pids.push_back(pid);
+    }
+
+    //a shard holds the rectangles with area clipped to its x-range grown by one unit, see tile
+    shard_report sent;
+    sent.bounds = xb;
+    bool ok = true;
+    for(size_t i=0;i<shards and ok;i++)
+    {
+        vector<rectangle> shard;
+        for(auto& r : rects)
+        {
+            if(r.x_int.bottom < r.x_int.top and r.y_int.bottom < r.y_int.top and r.x_int.bottom < xb[i+1]+1 and r.x_int.top > xb[i]-1)
+            {
+                rectangle c = r;
+                c.x_int.bottom = max(r.x_int.bottom, xb[i]-1);
+                c.x_int.top = min(r.x_int.top, xb[i+1]+1);
+                shard.push_back(c);
+            }
+        }
+        sent.rectangles.push_back(shard.size());
+        ok = send_records(sockets[i], shard);
+    }
+    vector<vector<line_segment>> horizontal(shards), vertical(shards);
+    for(size_t i=0;i<shards and ok;i++)
+    {
+        ok = receive_records(sockets[i], horizontal[i]) and receive_records(sockets[i], vertical[i]);
+        sent.pieces.push_back(horizontal[i].size()+vertical[i].size());
+    }
+    if(not finish() or not ok)
+    {
+        cerr << "sharded contour: a worker failed\n";
+        return false;
+    }
+
+    for(auto* parts : {&horizontal, &vertical})
+    {
+        vector<line_segment>& joined = parts == &horizontal ? out.horizontal : out.vertical;
+        joined.clear();
+        vector<size_t> next(shards, 0);
+        vector<piece_source> sources;
+        for(size_t i=0;i<shards;i++)
+        {
+            sources.push_back([parts, &next, i](line_segment& s)
+            {
+                if(next[i] == (*parts)[i].size())
+                {
+                    return false;
+                }
+                s = (*parts)[i][next[i]++];
+                return true;
+            });
+        }
+        stitch_pieces(sources, [&joined](const line_segment& s) { joined.push_back(s); });
+    }
+    out.polygons.clear();
+    if(options.engine.polygons)
+    {
+        assemble_polygons(out.horizontal, out.vertical, out.polygons);
+    }
+    if(report)
+    {
+        *report = move(sent);
+    }
+    return true;
+}
+
+bool batch_contour(const vector<vector<rectangle>>& sets, const batch_options& options, const batch_sink& sink, batch_report* report)
+{
+    for(const vector<rectangle>& set : sets)
+    {
+        if(not rectangles_fit(set.size(), "batch contour"))
+        {
+            return false;
+        }
+    }
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    size_t threads = max<size_t>(min(options.threads, sets.size()), 1);
+    //largest first: the sets still waiting when the threads run dry are the quick ones, so they even out the finishing times
+    vector<size_t> order(sets.size());
+    iota(order.begin(), order.end(), size_t(0));
+    stable_sort(order.begin(), order.end(), [&sets](size_t a, size_t b) { return sets[a].size() > sets[b].size(); });
+    engine_options engine = options.engine;
+    engine.threads = 1;
+    atomic<size_t> next(0);
+    atomic<bool> delivered(true);
+    vector<size_t> computed(threads, 0);
+    //every thread takes the next set in order as soon as it is done with its last one
+    auto work = [&](size_t self)
+    {
+        contour_engine own(engine);
+        contour_result result;
+        for(size_t k=next++;k<order.size();k=next++)
+        {
+            const vector<rectangle>& set = sets[order[k]];
+            own.compute(set.data(), set.size(), result);
+            if(not sink(order[k], result))
+            {
+                delivered = false;
+            }
+            computed[self]++;
+        }
+    };
+    if(threads == 1)
+    {
+        work(0);
+    }
+    else
+    {
+        task_pool pool(threads);
+        task_group group;
+        for(size_t t=1;t<threads;t++)
+        {
+            pool.spawn(group, [&work, t]() { work(t); });
+        }
+        work(0);
+        pool.wait(group);
+    }
+    if(report != NULL)
+    {
+        report->sets = sets.size();
+        report->rectangles = 0;
+        for(size_t k=0;k<sets.size();k++)
+        {
+            report->rectangles += sets[k].size();
+        }
+        report->seconds = chrono::duration<double>(chrono::steady_clock::now()-start).count();
+        report->per_thread = move(computed);
+    }
+    return delivered;
+}
@@ -0,0 +1,706 @@
+///@file
+///@brief Public interface of the contour library: the geometry types, the reusable contour engine, and the rectangle and contour file formats
+///
+///The library is Contours.cc; Main.cc is the command line driver, Benchmark.cc the benchmark driver and Tests.cc the test driver. Build with: g++ -O2 -std=c++17 -pthread Main.cc Contours.cc -o contours
+#ifndef CONTOURS_H
+#define CONTOURS_H
+#include<atomic>
+#include<condition_variable>
+#include<cstddef>
+#include<cstdint>
+#include<deque>
+#include<functional>
+#include<memory>
+#include<mutex>
+#include<string>
+#include<thread>
+#include<utility>
+#include<vector>
+///Brief description of points class
+///
+///The point structure contains two integers, representing the x and y coordinates of the point in 2D space
+typedef struct point
+{
+    long long x,y;
+}point;
+
+///Brief description of interval structure
+///
+///This structure contains two integers, representing the minimum coordinate and the maximum coordinate that is spanned by the interval.
+///The coordinate type is a parameter so that the divide and conquer can run on 32 bit coordinates when the input allows it; every public interface uses interval, its 64 bit instance
+template<class C> struct basic_interval
+{
+    ///Represents the smaller coordinate
+    C bottom;
+    ///Represents the larger coordinate    
+    C top;
+    ///Definition of comparator to facilitate set insertions in a sorted order
+    ///
+    bool operator<(const basic_interval& e) const
+    { 
+        if(this->bottom<e.bottom)
+        {
+            return true;
+        }
+        else if(this->bottom==e.bottom)
+        {
+            if(this->top<e.top)
+            {
+                return true;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        else
+        {
+            return false;
+        }
+    }
+};
+///Interval of 64 bit coordinates
+typedef basic_interval<long long> interval;
+
+///Brief description of line segment structure
+///
+///This structure contains a fixed coordinate x and an interval which represents the range of coordinates on the alternate axis from x
+typedef struct line_segment
+{
+    ///Represents the range of coordinates on the alternate axis
+	interval inter;
+    ///Represents the fixed point on a certain axis
+	long long x;
+    ///Definition of comparator to facilitate set insertions in a sorted order
+    ///
+	bool operator<(const line_segment& e) const
+    { 
+        if(this->x<e.x)
+		{
+			return true;
+		}
+		else if(this->x==e.x)
+		{
+			if(this->inter.bottom<e.inter.bottom)
+			{
+				return true;
+			}
+			else if(this->inter.bottom==e.inter.bottom)
+			{
+				if(this->inter.top<e.inter.top)
+				{
+					return true;
+				}
+				else
+				{
+					return false;
+				}
+			}
+			else
+			{
+				return false;
+			}
+		}
+        else
+        {
+            return false;
+        }
+    }
+
+}line_segment;
+
+///Brief description of rectangle structure
+///
+///This structure contains two intervals that can define a rectangle along with a unique ID
+typedef struct rectangle
+{
+    ///Interval data structure that contains the x-bounds of the rectangle 
+    interval x_int;
+    ///Interval data structure that contains the y-bounds of the rectangle
+    interval y_int;
+    ///Unique ID given in the order of input to identify each rectangle separately
+    long long id;
+    
+}rectangle;
+
+///Brief description of parallel options
+///
+///Collects the knobs of the multi-core paths: the problem sizes below which work stays on one core
+typedef struct parallel_options
+{
+    ///Edge ranges of stripes() with at most this many edges are solved by a single task
+    size_t dac_cutoff = 2048;
+    ///Merges of stripes() producing fewer than twice this many stripes run on a single task
+    size_t merge_cutoff = 8192;
+    ///Number of horizontal edges that contour() hands to one task, rounded up to the next change of y
+    size_t contour_chunk = 4096;
+}parallel_options;
+
+///Brief description of engine algorithm enumeration
+///
+///Selects the algorithm that produces the horizontal contour pieces
+enum engine_algorithm
+{
+    ///Guting's divide and conquer over stripes, rectangle_DAC followed by contour
+    ENGINE_DAC,
+    ///Plane sweep over a coverage tree, sweep_contour
+    ENGINE_SWEEP
+};
+
+///Brief description of engine options
+///
+///Fixes how a contour engine computes; the options cannot change during the life of the engine
+typedef struct engine_options
+{
+    ///Algorithm producing the horizontal contour pieces
+    engine_algorithm algorithm = ENGINE_DAC;
+    ///Workers of the task pool the engine starts for itself; 1 keeps every phase on the calling thread
+    size_t threads = 1;
+    ///Cutoffs of the parallel phases
+    parallel_options par;
+    ///Whether compute also chains the contour into closed polygons
+    bool polygons = false;
+    ///Whether the divide and conquer also runs on the transposed rectangles, at the same time as on the original ones, and takes the vertical contours from there instead of pairing up the ends of the horizontal contours. The sweep ignores it
+    bool transposed = false;
+}engine_options;
+
+///Brief description of contour polygon
+///
+///One closed ring of the contour. Outer boundaries run counterclockwise and holes clockwise, so the union always lies to the left of the direction of travel
+typedef struct contour_polygon
+{
+    ///Corners in order, starting at the lowest corner on the leftmost side; the ring closes from the last corner back to the first, and horizontal and vertical edges alternate
+    std::vector<point> vertices;
+    ///Index of the ring this one lies directly inside, -1 for a ring inside no other
+    long long parent = -1;
+    ///Number of rings around this one: even for outer boundaries, odd for holes
+    int depth = 0;
+}contour_polygon;
+
+///Brief description of contour result
+///
+///The contour of a set of rectangles as maximal segments
+typedef struct contour_result
+{
+    ///Horizontal contours with y as the fixed coordinate, sorted
+    std::vector<line_segment> horizontal;
+    ///Vertical contours with x as the fixed coordinate, sorted
+    std::vector<line_segment> vertical;
+    ///The contours chained into rings, listed outer boundaries and holes alike; only filled when engine_options::polygons is set
+    std::vector<contour_polygon> polygons;
+}contour_result;
+
+///Brief description of engine report
+///
+///What the last computation of a contour engine did
+typedef struct engine_report
+{
+    ///Number of final stripes; 0 for the sweep
+    size_t stripes = 0;
+    ///Number of ctree nodes allocated; 0 for the sweep
+    size_t ctree_nodes = 0;
+    ///Bytes of ctree slabs the engine keeps for the next computation
+    size_t arena_bytes = 0;
+    ///Number of horizontal contour pieces before merging
+    size_t pieces = 0;
+    ///Wall time in seconds of every phase, in the order the phases ran
+    std::vector<std::pair<const char*,double>> phases;
+}engine_report;
+
+///Unsigned 128 bit integer holding the measures of a union
+__extension__ typedef unsigned __int128 measure_int;
+
+///Brief description of union measures
+///
+///Measures of the union of a set of rectangles, equal to what the contour computed by an engine adds up to.
+///They are exact for any input: the area stays below (2^64)^2, and every length below 4*MAX_RECTANGLES*2^64, since the contour lies on the edges of the rectangles
+typedef struct union_measures
+{
+    ///Area of the union
+    measure_int area = 0;
+    ///Length of the contour, horizontal_length plus vertical_length
+    measure_int perimeter = 0;
+    ///Total length of the horizontal contours
+    measure_int horizontal_length = 0;
+    ///Total length of the vertical contours
+    measure_int vertical_length = 0;
+    ///Number of contour vertices, the two ends of every horizontal contour
+    size_t vertices = 0;
+}union_measures;
+
+///Most rectangles one computation accepts: the divide and conquer and the sweep tell rectangles apart by 32 bit IDs
+const size_t MAX_RECTANGLES = size_t(INT32_MAX);
+
+///Brief description of contour engine
+///
+///Computes contours of rectangle sets, one set per call. The ctree arena, the task pool and the edge and piece buffers stay allocated between calls, so a stream of small computations runs on warm memory.
+///An engine holds no state shared with other engines: different threads may compute at the same time as long as each uses its own engine
+class contour_engine
+{
+public:
+    explicit contour_engine(const engine_options& options = engine_options());
+    ~contour_engine();
+    contour_engine(const contour_engine&) = delete;
+    contour_engine& operator=(const contour_engine&) = delete;
+
+    /*! Computes the contour of a set of rectangles
+        \param rects first rectangle; the IDs of the rectangles are ignored, rectangles are told apart by their position
+        \param n number of rectangles
+        \param out receives the contour; its buffers are reused
+        \return false, reporting to the error stream and leaving out unchanged, if n exceeds MAX_RECTANGLES
+    */
+    bool compute(const rectangle* rects, size_t n, contour_result& out);
+
+    /*! Computes the contour of a set of rectangles
+        \param rects the rectangles
+        \return The contour; empty if there are more than MAX_RECTANGLES rectangles
+    */
+    contour_result compute(const std::vector<rectangle>& rects);
+
+    /*! Measures the union of a set of rectangles without building its contour. Whatever the algorithm of the engine, a plane sweep does the work in memory linear in the number of rectangles; rectangles without area are skipped
+        \param rects first rectangle
+        \param n number of rectangles
+        \param out receives the measures
+        \return false, reporting to the error stream and leaving out unchanged, if n exceeds MAX_RECTANGLES
+    */
+    bool measure(const rectangle* rects, size_t n, union_measures& out);
+
+    ///What the last call of compute did
+    const engine_report& report() const;
+
+    ///The options the engine was created with
+    const engine_options& options() const;
+
+    ///Frees the memory kept between computations; the next computation allocates it again
+    void release();
+
+private:
+    struct engine_state;
+    std::unique_ptr<engine_state> state;
+};
+
+///Brief description of contour delta
+///
+///The maximal contour segments that one update of a dynamic contour removed and added. A segment that only changed its extent appears in both lists, with its old and its new extent
+typedef struct contour_delta
+{
+    std::vector<line_segment> added_horizontal;
+    std::vector<line_segment> removed_horizontal;
+    std::vector<line_segment> added_vertical;
+    std::vector<line_segment> removed_vertical;
+}contour_delta;
+
+///Brief description of dynamic contour
+///
+///Keeps the contour of a changing set of rectangles, keyed by rectangle::id. An update only touches the closed box of the rectangle inserted or erased: the contour segments meeting that box are recomputed from the rectangles meeting it, so the cost follows the size of the affected region rather than the number of rectangles.
+///Rectangles and contour segments are found through uniform grids. Only rectangles with positive width and height take part, at most MAX_RECTANGLES of them
+class dynamic_contour
+{
+public:
+    /*! Starts from the contour of an initial set of rectangles
+        \param initial the rectangles; ones with an ID already seen or without area are skipped
+        \param cell side of a grid cell; 0 picks four times the mean side of the initial rectangles
+    */
+    explicit dynamic_contour(const std::vector<rectangle>& initial = std::vector<rectangle>(), long long cell = 0);
+    ~dynamic_contour();
+    dynamic_contour(const dynamic_contour&) = delete;
+    dynamic_contour& operator=(const dynamic_contour&) = delete;
+
+    /*! Adds a rectangle
+        \param r the rectangle, identified by its ID
+        \param delta receives the changes of the contour
+        \return false, leaving everything unchanged, if the ID is taken or the rectangle has no area
+    */
+    bool insert(const rectangle& r, contour_delta& delta);
+
+    /*! Removes a rectangle
+        \param id ID of the rectangle
+        \param delta receives the changes of the contour
+        \return false, leaving everything unchanged, if no rectangle has this ID
+    */
+    bool erase(long long id, contour_delta& delta);
+
+    ///Number of rectangles
+    size_t size() const;
+
+    /*! Lists the whole current contour
+        \param out receives the contour, sorted
+    */
+    void contour(contour_result& out) const;
+
+private:
+    struct dynamic_state;
+    std::unique_ptr<dynamic_state> state;
+    ///Recomputes the contour inside the closed box of r, which was just inserted or erased
+    void update(const rectangle& r, contour_delta& delta);
+};
+
+///Brief description of tiled options
+///
+///Bounds of an out-of-core computation by tiled_contour
+typedef struct tiled_options
+{
+    ///Bytes the computation may hold in memory: the rectangles of one tile together with the structures built for its contour, and separately the buffers of the passes over the input and over the temporary files
+    size_t memory_budget = size_t(1)<<30;
+    ///Directory for the temporary files; empty uses $TMPDIR, or /tmp when that is unset
+    std::string temp_dir;
+}tiled_options;
+
+///Brief description of tiled report
+///
+///What a call of tiled_contour did
+typedef struct tiled_report
+{
+    ///Number of input rectangles
+    size_t rectangles = 0;
+    ///Number of tiles whose contour was computed
+    size_t tiles = 0;
+    ///Number of tiles skipped because a single rectangle covers them
+    size_t covered_tiles = 0;
+    ///Number of tiles split in four for holding more rectangles than the budget allows
+    size_t splits = 0;
+    ///Number of computed tiles that still held more rectangles than the budget allows, because splitting stopped shrinking them
+    size_t over_budget_tiles = 0;
+    ///Most rectangles in one computed tile
+    size_t largest_tile = 0;
+    ///Bytes written to temporary files
+    size_t spill_bytes = 0;
+}tiled_report;
+
+///Receives the segments of a tiled computation, horizontal ones first, each direction sorted
+typedef std::function<void(const line_segment& segment, bool horizontal)> segment_sink;
+
+/*! Computes the contour of the rectangles in a file without holding them all in memory.
+    The frame of the rectangles is cut into tiles, the rectangles are distributed to the tiles through temporary files, and the contour of each tile is computed alone, clipped to the tile.
+    The clipped pieces are spilled to sorted files and joined across the tile seams by a final merge, so the output is exactly the contour computed in memory.
+    Like dynamic_contour, only rectangles with positive width and height take part
+    \param path file holding the rectangles in either input format; it is read twice, so standard input is refused
+    \param options memory budget and temporary directory
+    \param sink receives the maximal contour segments
+    \param report receives what the computation did, unless NULL
+    \return false, after reporting on cerr, if a file cannot be read or written, or a tile that cannot be split holds more than MAX_RECTANGLES rectangles
+*/
+bool tiled_contour(const std::string& path, const tiled_options& options, const segment_sink& sink, tiled_report* report = NULL);
+
+///Brief description of shard options
+///
+///How sharded_contour spreads a computation over worker processes
+typedef struct shard_options
+{
+    ///Worker processes; each computes the contour of one x-range
+    size_t workers = 2;
+    ///Engine every worker runs; its threads are divided among the workers
+    engine_options engine;
+}shard_options;
+
+///Brief description of shard report
+///
+///What a call of sharded_contour did
+typedef struct shard_report
+{
+    ///Boundaries of the x-ranges of the shards, one more than there are shards
+    std::vector<long long> bounds;
+    ///Rectangles sent to each shard
+    std::vector<size_t> rectangles;
+    ///Contour pieces received from each shard
+    std::vector<size_t> pieces;
+}shard_report;
+
+/*! Computes the contour of a set of rectangles in worker processes, each with its own address space and allocator.
+    The x-range of the frame is cut where the vertical edges split evenly, each worker receives the rectangles clipped to its x-range over a Unix socket and returns its contour clipped to that range, and the pieces are joined across the cuts, so the output is the contour an engine computes.
+    Like dynamic_contour, only rectangles with positive width and height take part. The workers are forked from the calling process, so it must be called before the process starts any other thread: a lock held by another thread at the fork stays held forever in the workers.
+    The statistics of the workers are not sent back
+    \param rects the rectangles
+    \param options number of workers and their engine
+    \param out receives the contour
+    \param report receives what the computation did, unless NULL
+    \return false, after reporting on cerr, if there are more than MAX_RECTANGLES rectangles, or a worker could not be started or failed
+*/
+bool sharded_contour(const std::vector<rectangle>& rects, const shard_options& options, contour_result& out, shard_report* report = NULL);
+
+///Brief description of batch options
+///
+///How batch_contour spreads many independent rectangle sets over threads
+typedef struct batch_options
+{
+    ///Sets computed at the same time, each on one thread
+    size_t threads = 1;
+    ///Engine every set runs; its threads and task pool are ignored, since the sets themselves are what runs in parallel
+    engine_options engine;
+}batch_options;
+
+///Brief description of batch report
+///
+///What a call of batch_contour did
+typedef struct batch_report
+{
+    ///Number of sets computed
+    size_t sets = 0;
+    ///Number of rectangles over all sets
+    size_t rectangles = 0;
+    ///Wall time of the whole batch in seconds, output included
+    double seconds = 0;
+    ///Sets computed by each thread
+    std::vector<size_t> per_thread;
+}batch_report;
+
+///Receives the contour of one set of a batch, with the position of the set in the batch; returns false if it could not use it. It is called from several threads at once, never twice for the same set
+typedef std::function<bool(size_t set, const contour_result& result)> batch_sink;
+
+/*! Computes the contours of many independent rectangle sets, each with its own frame and its own run of the engine, as if every set were computed by a separate engine.
+    The sets are handed out largest first to whichever thread is free, so a large set does not start last behind many small ones. Every thread keeps one engine, and with it the arena and buffers, for all the sets it computes
+    \param sets the rectangle sets
+    \param options number of threads and the engine every set runs
+    \param sink receives the contour of every set as soon as it is computed
+    \param report receives what the computation did, unless NULL
+    \return false if sink returned false for any set, the remaining sets being computed all the same; false without computing any set, after reporting on cerr, if a set holds more than MAX_RECTANGLES rectangles
+*/
+bool batch_contour(const std::vector<std::vector<rectangle>>& sets, const batch_options& options, const batch_sink& sink, batch_report* report = NULL);
+
+/*! Chains contours into closed rings, orients them and nests the holes in their boundaries, in O(n log n)
+    \param hrc Horizontal contours, sorted
+    \param vrc Vertical contours, sorted
+    \param polygons receives the rings
+    \return false, leaving polygons incomplete, if the contours do not close into rings; only rectangles without area lead to such contours
+*/
+bool assemble_polygons(const std::vector<line_segment>& hrc, const std::vector<line_segment>& vrc, std::vector<contour_polygon>& polygons);
+
+/*! Reports to the error stream where two sorted lists of contours differ
+    \param what names the kind of contours being compared
+    \param a contours computed by the selected engine, sorted
+    \param b contours computed by the other engine, sorted
+    \return true when both lists are equal
+*/
+bool compare_contours(const char* what, const std::vector<line_segment>& a, const std::vector<line_segment>& b);
+
+/*! Checks that horizontal and vertical contours computed apart, as with engine_options::transposed, describe the same boundary: every end of a horizontal contour must be the end of exactly one vertical contour, and the other way round. Reports the first offending corner to the error stream
+    \param hrc Horizontal contours
+    \param vrc Vertical contours
+    \return true when both directions have the same corners
+*/
+bool consistent_contours(const std::vector<line_segment>& hrc, const std::vector<line_segment>& vrc);
+
+/*! Turns on the statistics report, printed to the error stream at exit
+    \param json report as JSON instead of text
+    \return false if the library was built without CONTOURS_STATS, in which case nothing is recorded
+*/
+bool stats_enable(bool json);
+
+/*! Turns on the memory trace of the divide and conquer: the live bytes of its stripes, ctree nodes and L, R and P sets are followed as the recursion runs. The peak of every recursion depth is added to the statistics report, and a timeline of the live bytes is written as CSV to a file at exit
+    \param path file receiving the timeline
+    \return false if the library was built without CONTOURS_STATS, in which case nothing is traced
+*/
+bool stats_trace_memory(const std::string& path);
+
+///Brief description of binary encoding enumeration
+///
+///Layout of the rectangles that follow the header of a binary rectangle file. All integers are little endian
+enum binary_encoding : uint32_t
+{
+    ///Four 64 bit integers x1 x2 y1 y2 per rectangle, so the payload is exactly 32 bytes per rectangle
+    ENCODING_FIXED = 0,
+    ///Each of x1 x2 y1 y2 as the zigzag LEB128 varint of its difference to the same field of the previous rectangle
+    ENCODING_DELTA = 1
+};
+
+/*! Converts between host order and the little endian order of the binary format
+    \param v value in one order
+    \return the value in the other order
+*/
+inline uint64_t byte_order_le(uint64_t v)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return __builtin_bswap64(v);
+#else
+    return v;
+#endif
+}
+
+/*! Parses rectangles in either input format, telling them apart by the magic bytes of the binary one
+    \param p start of the input
+    \param end end of the input
+    \param rects receives the rectangles
+    \return false, after reporting on cerr, if the input is malformed
+*/
+bool parse_rectangles(const char* p, const char* end, std::vector<rectangle>& rects);
+
+/*! Loads rectangles in either input format from a file, or from standard input
+    \param path file to load, or "-" for standard input
+    \param rects receives the rectangles
+    \return false, after reporting on cerr, if the file cannot be read or is malformed
+*/
+bool load_rectangles(const std::string& path, std::vector<rectangle>& rects);
+
+/*! Parses a batch: any number of independent rectangle sets stored one after another, each in either input format, that is a text count followed by its rectangles or a whole binary file
+    \param p start of the input
+    \param end end of the input
+    \param sets receives the sets in input order, the rectangles of each numbered from 0
+    \return false, after reporting on cerr, if a set is malformed
+*/
+bool parse_rectangle_sets(const char* p, const char* end, std::vector<std::vector<rectangle>>& sets);
+
+/*! Loads a batch of rectangle sets, as parse_rectangle_sets reads them, from a file, or from standard input
+    \param path file to load, or "-" for standard input
+    \param sets receives the sets in input order
+    \return false, after reporting on cerr, if the file cannot be read or is malformed
+*/
+bool load_rectangle_sets(const std::string& path, std::vector<std::vector<rectangle>>& sets);
+
+/*! Writes rectangles in the binary input format
+    \param rects rectangles to write, in order
+    \param path file to create or overwrite
+    \param encoding payload layout, see binary_encoding
+    \return false, after reporting on cerr, if the file cannot be written
+*/
+bool write_binary_rectangles(const std::vector<rectangle>& rects, const std::string& path, binary_encoding encoding);
+
+///Brief description of output writer
+///
+///Buffered writer behind every output of the program. Bytes are collected in large buffers and integers are formatted by hand, so nothing flushes until a buffer fills.
+///With async set, full buffers are handed to a writer thread, so formatting the next buffer overlaps with the write system calls of the previous ones
+class output_writer
+{
+public:
+    ///Size of one buffer, and thus of most write system calls
+    static const size_t BUFFER_BYTES = 1<<20;
+    ///Full buffers allowed to wait for the writer thread before the producer blocks
+    static const size_t MAX_QUEUED = 8;
+
+    output_writer() = default;
+    output_writer(const output_writer&) = delete;
+    output_writer& operator=(const output_writer&) = delete;
+    ~output_writer();
+
+    /*! Starts writing to a file, or to standard output
+        \param path file to create or truncate, or "-" for standard output
+        \param async whether a writer thread performs the writes
+        \return false, after reporting on cerr, if the file cannot be created
+    */
+    bool open(const std::string& path, bool async);
+
+    /*! Appends bytes
+        \param p first byte
+        \param n number of bytes
+    */
+    void write(const char* p, size_t n);
+
+    /*! Appends a string literal or other C string
+        \param text the string
+    */
+    void put(const char* text);
+
+    /*! Appends an integer in decimal
+        \param v the integer
+    */
+    void put(long long v);
+
+    /*! Appends a measure of a union in decimal
+        \param v the measure
+    */
+    void put_measure(measure_int v);
+
+    /*! Appends a 64 bit integer as 8 little endian bytes
+        \param v the integer
+    */
+    void put_binary(uint64_t v);
+
+    /*! Writes out everything appended so far, stops the writer thread and closes the file
+        \return false, after reporting on cerr, if any write failed
+    */
+    bool close();
+
+private:
+    /*! Passes the current buffer on, to the writer thread if there is one
+    */
+    void hand_off();
+
+    /*! Body of the writer thread: writes queued buffers in order until closed
+    */
+    void drain();
+
+    /*! Writes a whole buffer to the file, retrying short and interrupted writes
+        \param buffer bytes to write
+    */
+    void write_all(const std::string& buffer);
+
+    /*! Remembers the first error of the writer
+        \param e errno of the failure
+    */
+    void fail(int e);
+
+    std::string name;
+    int fd = -1;
+    bool owned = false;
+    std::atomic<bool> failed{false};
+    int error = 0;
+    std::string current;
+    std::thread worker;
+    std::mutex m;
+    std::condition_variable ready, room;
+    std::deque<std::string> queue;
+    std::vector<std::string> spare;
+    bool done = false;
+};
+
+/*! Writes the input rectangles, preceded by their frame, in the rectangles.csv format used for visualization
+    \param out writer receiving the text
+    \param rects the input rectangles
+*/
+void write_rectangles_csv(output_writer& out, const std::vector<rectangle>& rects);
+
+/*! Writes the rectangles of a file, preceded by their frame, in the rectangles.csv format without holding them all in memory
+    \param out writer receiving the text
+    \param path file holding the rectangles in either input format; it is read twice
+    \return false, after reporting on cerr, if the file cannot be read or is malformed
+*/
+bool write_rectangles_csv(output_writer& out, const std::string& path);
+
+/*! Writes one contour segment as a line of contours.csv
+    \param out writer receiving the text
+    \param ls the segment
+    \param horizontal whether the segment is horizontal
+*/
+void put_segment_csv(output_writer& out, const line_segment& ls, bool horizontal);
+
+/*! Writes one contour segment as a line of the listing that main prints
+    \param out writer receiving the text
+    \param ls the segment
+    \param horizontal whether the segment is horizontal
+*/
+void put_segment_text(output_writer& out, const line_segment& ls, bool horizontal);
+
+/*! Writes the contours as x1, y1, x2, y2 lines in the contours.csv format used for visualization
+    \param out writer receiving the text
+    \param hrc Horizontal contours, sorted
+    \param vrc Vertical contours, sorted
+*/
+void write_contours_csv(output_writer& out, const std::vector<line_segment>& hrc, const std::vector<line_segment>& vrc);
+
+/*! Writes the contours in the human readable listing that main prints on standard output
+    \param out writer receiving the text
+    \param hrc Horizontal contours, sorted
+    \param vrc Vertical contours, sorted
+*/
+void write_contours_text(output_writer& out, const std::vector<line_segment>& hrc, const std::vector<line_segment>& vrc);
+
+/*! Writes polygons as text: for every ring a line "Polygon index outer|hole parent corners", then one "x y" line per corner
+    \param out writer receiving the text
+    \param polygons the rings
+*/
+void write_polygons_text(output_writer& out, const std::vector<contour_polygon>& polygons);
+
+/*! Writes the contours in the binary segment format: the magic bytes, the number of horizontal and of vertical segments as 64 bit integers, then every segment as its fixed coordinate followed by the two ends of its interval, horizontal segments first. All integers are little endian
+    \param out writer receiving the bytes
+    \param hrc Horizontal contours, sorted
+    \param vrc Vertical contours, sorted
+*/
+void write_contours_binary(output_writer& out, const std::vector<line_segment>& hrc, const std::vector<line_segment>& vrc);
+
+/*! Function that writes the coordinates of the line segments that form the horizontal and vertical contours, along with the input rectangles into separate files for later use in visualization
+    \param rects the input rectangles
+    \param hrc Horizontal contours, sorted
+    \param vrc Vertical contours, sorted
+    \return false, after reporting on cerr, if a file cannot be written
+*/
+bool csv_writer(const std::vector<rectangle>& rects, const std::vector<line_segment>& hrc, const std::vector<line_segment>& vrc);
+#endif
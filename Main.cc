@@ -0,0 +1,516 @@
+///@file
+///@brief Command line driver of the contour library: reads rectangles, prints their contour and writes the csv files used for visualization
+///
+///Build with: g++ -O2 -std=c++17 -pthread Main.cc Contours.cc -o contours
+#include "Contours.h"
+#include<bits/stdc++.h>
+#include<sys/stat.h>
+using namespace std;
+typedef long long int ll;
+
+/*! Prints the command line options understood by main
+    \param prog name the program was started with
+*/
+void usage(const char* prog)
+{
+    cerr << "usage: " << prog << " [--engine dac|sweep] [--transposed] [--check] [--stats[=json]] [--memory-trace FILE] [--threads N] [--cutoff N] [--merge-cutoff N] [--input FILE] [--convert FILE] [--convert-fixed FILE] [--output FILE] [--binary-output FILE] [--quiet] [--no-csv] [--sync-output] [--tiled] [--memory-budget MB] [--temp-dir DIR] [--processes N] [--measure] [--polygons FILE] [--batch DIR] < rectangles.txt\n";
+    cerr << "  --input FILE      read the rectangles from FILE instead of standard input; text or binary is detected from the content\n";
+    cerr << "  --convert FILE    write the rectangles to FILE in the delta varint binary format and exit\n";
+    cerr << "  --convert-fixed FILE  same, in the fixed width binary format\n";
+    cerr << "  --output FILE     write the contour listing to FILE instead of standard output\n";
+    cerr << "  --binary-output FILE  also write the contours to FILE in the binary segment format\n";
+    cerr << "  --polygons FILE   also write the contour as closed rings, outer boundaries counterclockwise and holes clockwise, to FILE\n";
+    cerr << "  --quiet           skip the contour listing\n";
+    cerr << "  --no-csv          skip rectangles.csv and contours.csv\n";
+    cerr << "  --sync-output     write on the calling thread instead of a writer thread\n";
+    cerr << "  --engine E        dac: Guting's divide and conquer (default), sweep: plane sweep over a coverage tree\n";
+    cerr << "  --transposed      take the vertical contours from a divide and conquer on the transposed rectangles, run alongside the first\n";
+    cerr << "  --check           also run the other engine and report any difference, and check that the horizontal and vertical contours meet at the same corners; exits with status 2 on mismatch\n";
+    cerr << "  --stats[=json]    print phase timings and counters to stderr at exit (needs a -DCONTOURS_STATS build)\n";
+    cerr << "  --memory-trace FILE  follow the live bytes of the divide and conquer and write their timeline to FILE as CSV; with --stats the report adds the peak of every recursion depth (needs a -DCONTOURS_STATS build)\n";
+    cerr << "  --threads N       worker threads for the divide and conquer (default: all cores)\n";
+    cerr << "  --cutoff N        edge ranges of at most N edges are solved on one core\n";
+    cerr << "  --merge-cutoff N  merges of fewer than 2N stripes run on one core\n";
+    cerr << "  --tiled           compute tile by tile through temporary files, for inputs that do not fit in memory; needs --input FILE\n";
+    cerr << "  --memory-budget MB  memory a tiled run may use (default 1024); implies --tiled\n";
+    cerr << "  --temp-dir DIR    directory for the temporary files of a tiled run (default: $TMPDIR or /tmp)\n";
+    cerr << "  --measure         print the area, perimeter and vertex count of the union instead of its contour; --check compares them with the contour\n";
+    cerr << "  --processes N     compute in N worker processes, each owning an x-range of the input; the threads are divided among them\n";
+    cerr << "  --batch DIR       the input holds many rectangle sets one after another; compute them on all threads, one set per thread, and write the contour listing of set k to DIR/k.txt\n";
+}
+
+/*! Computes the measures of the union, prints them and, if asked, checks them against the contour computed by the engine
+    \param rects the rectangles
+    \param options options of the engine
+    \param output file receiving the measures
+    \param check whether the perimeter and the vertex count are compared with those of the contour
+    \return The exit status of the program
+*/
+int run_measure(const vector<rectangle>& rects, const engine_options& options, const string& output, bool check)
+{
+    contour_engine engine(options);
+    union_measures measures;
+    if(not engine.measure(rects.data(), rects.size(), measures))
+    {
+        return 1;
+    }
+    int status = 0;
+    if(check)
+    {
+        contour_result contours;
+        if(not engine.compute(rects.data(), rects.size(), contours))
+        {
+            return 1;
+        }
+        measure_int horizontal = 0, vertical = 0;
+        for(auto& s : contours.horizontal)
+        {
+            horizontal += uint64_t(s.inter.top)-uint64_t(s.inter.bottom);
+        }
+        for(auto& s : contours.vertical)
+        {
+            vertical += uint64_t(s.inter.top)-uint64_t(s.inter.bottom);
+        }
+        if(horizontal != measures.horizontal_length or vertical != measures.vertical_length or 2*contours.horizontal.size() != measures.vertices)
+        {
+            cerr << "measures differ from the contour: " << (horizontal != measures.horizontal_length ? "horizontal length" : vertical != measures.vertical_length ? "vertical length" : "vertex count") << "\n";
+            status = 2;
+        }
+        else
+        {
+            cerr << "measures agree with the contour\n";
+        }
+    }
+    output_writer out;
+    if(not out.open(output, false))
+    {
+        return 1;
+    }
+    out.put("Area "); out.put_measure(measures.area); out.put("\n");
+    out.put("Perimeter "); out.put_measure(measures.perimeter); out.put("\n");
+    out.put("Horizontal length "); out.put_measure(measures.horizontal_length); out.put("\n");
+    out.put("Vertical length "); out.put_measure(measures.vertical_length); out.put("\n");
+    out.put("Vertices "); out.put((ll)measures.vertices); out.put("\n");
+    return out.close() ? status : 1;
+}
+
+/*! Runs the tiled computation and writes its outputs, which are the same as those of the in-memory path
+    \param input file holding the rectangles
+    \param options memory budget and temporary directory
+    \param output file receiving the contour listing, or empty to skip it
+    \param write_csv whether rectangles.csv and contours.csv are written
+    \param async_output whether writer threads perform the writes
+    \return The exit status of the program
+*/
+int run_tiled(const string& input, const tiled_options& options, const string& output, bool write_csv, bool async_output)
+{
+    //rectangles.csv depends on the input alone, so it is written while the contours are computed
+    future<bool> rectangles_csv;
+    if(write_csv)
+    {
+        rectangles_csv = async(launch::async, [&input]()
+        {
+            output_writer out;
+            if(not out.open("rectangles.csv", false))
+            {
+                return false;
+            }
+            bool ok = write_rectangles_csv(out, input);
+            return out.close() and ok;
+        });
+    }
+    output_writer text, csv;
+    bool listing = not output.empty() and text.open(output, async_output);
+    bool contours_csv = write_csv and csv.open("contours.csv", async_output);
+    bool written = listing == not output.empty() and contours_csv == write_csv;
+    if(listing)
+    {
+        text.put("Horizontal Contours\n");
+    }
+    if(contours_csv)
+    {
+        csv.put("Contours\n");
+    }
+    bool vertical = false;
+    bool computed = tiled_contour(input, options, [&](const line_segment& s, bool horizontal)
+    {
+        if(listing and not horizontal and not vertical)
+        {
+            text.put("Vertical Contours\n");
+            vertical = true;
+        }
+        if(listing)
+        {
+            put_segment_text(text, s, horizontal);
+        }
+        if(contours_csv)
+        {
+            put_segment_csv(csv, s, horizontal);
+        }
+    });
+    if(listing and not vertical)
+    {
+        text.put("Vertical Contours\n");
+    }
+    written = text.close() and written;
+    written = csv.close() and written;
+    if(write_csv)
+    {
+        written = rectangles_csv.get() and written;
+    }
+    return computed and written ? 0 : 1;
+}
+
+/*! Computes the contours of a batch of rectangle sets and writes one listing per set
+    \param input file holding the sets
+    \param directory directory receiving the listings; it is created if missing
+    \param options engine every set runs
+    \param threads sets computed at the same time
+    \param listing whether the listings are written at all
+    \return The exit status of the program
+*/
+int run_batch(const string& input, const string& directory, const engine_options& options, size_t threads, bool listing)
+{
+    vector<vector<rectangle>> sets;
+    if(not load_rectangle_sets(input, sets))
+    {
+        return 1;
+    }
+    if(listing and mkdir(directory.c_str(), 0777) != 0 and errno != EEXIST)
+    {
+        cerr << directory << ": " << strerror(errno) << "\n";
+        return 1;
+    }
+    batch_options batching;
+    batching.threads = threads;
+    batching.engine = options;
+    batch_report report;
+    bool written = batch_contour(sets, batching, [&](size_t set, const contour_result& result)
+    {
+        if(not listing)
+        {
+            return true;
+        }
+        output_writer out;
+        if(not out.open(directory + "/" + to_string(set) + ".txt", false))
+        {
+            return false;
+        }
+        write_contours_text(out, result.horizontal, result.vertical);
+        return out.close();
+    }, &report);
+    cerr << report.sets << " sets of " << report.rectangles << " rectangles in " << report.seconds << " s, " << (report.seconds > 0 ? report.sets/report.seconds : 0.0) << " sets/s\n";
+    return written ? 0 : 1;
+}
+
+int main(int argc, char** argv)
+{
+    size_t threads = max<unsigned>(thread::hardware_concurrency(),1);
+    parallel_options par;
+    engine_algorithm algorithm = ENGINE_DAC;
+    bool check = false;
+    bool transposed = false;
+    bool stats = false;
+    bool stats_json = false;
+    string memory_trace;
+    string input = "-";
+    string convert;
+    binary_encoding convert_encoding = ENCODING_DELTA;
+    string output = "-";
+    string binary_output;
+    string polygons_output;
+    bool quiet = false;
+    bool write_csv = true;
+    bool async_output = true;
+    size_t processes = 0;
+    bool measure = false;
+    bool tiled = false;
+    tiled_options tiling;
+    string batch;
+    for(int a=1;a<argc;a++)
+    {
+        string opt = argv[a];
+        if(a+1 < argc and opt == "--threads")
+        {
+            threads = max(atoll(argv[++a]),1LL);
+        }
+        else if(a+1 < argc and opt == "--cutoff")
+        {
+            par.dac_cutoff = max(atoll(argv[++a]),1LL);
+        }
+        else if(a+1 < argc and opt == "--merge-cutoff")
+        {
+            par.merge_cutoff = max(atoll(argv[++a]),1LL);
+        }
+        else if(a+1 < argc and opt == "--engine" and (string(argv[a+1]) == "dac" or string(argv[a+1]) == "sweep"))
+        {
+            algorithm = string(argv[++a]) == "sweep" ? ENGINE_SWEEP : ENGINE_DAC;
+        }
+        else if(opt == "--transposed")
+        {
+            transposed = true;
+        }
+        else if(opt == "--check")
+        {
+            check = true;
+        }
+        else if(a+1 < argc and opt == "--input")
+        {
+            input = argv[++a];
+        }
+        else if(a+1 < argc and opt == "--output")
+        {
+            output = argv[++a];
+        }
+        else if(a+1 < argc and opt == "--binary-output")
+        {
+            binary_output = argv[++a];
+        }
+        else if(a+1 < argc and opt == "--polygons")
+        {
+            polygons_output = argv[++a];
+        }
+        else if(opt == "--quiet")
+        {
+            quiet = true;
+        }
+        else if(opt == "--no-csv")
+        {
+            write_csv = false;
+        }
+        else if(opt == "--sync-output")
+        {
+            async_output = false;
+        }
+        else if(a+1 < argc and (opt == "--convert" or opt == "--convert-fixed"))
+        {
+            convert = argv[++a];
+            convert_encoding = opt == "--convert" ? ENCODING_DELTA : ENCODING_FIXED;
+        }
+        else if(a+1 < argc and opt == "--processes")
+        {
+            processes = max(atoll(argv[++a]),1LL);
+        }
+        else if(opt == "--measure")
+        {
+            measure = true;
+        }
+        else if(opt == "--tiled")
+        {
+            tiled = true;
+        }
+        else if(a+1 < argc and opt == "--memory-budget")
+        {
+            tiled = true;
+            tiling.memory_budget = size_t(max(atoll(argv[++a]),1LL)) << 20;
+        }
+        else if(a+1 < argc and opt == "--temp-dir")
+        {
+            tiling.temp_dir = argv[++a];
+        }
+        else if(a+1 < argc and opt == "--batch")
+        {
+            batch = argv[++a];
+        }
+        else if(a+1 < argc and opt == "--memory-trace")
+        {
+            memory_trace = argv[++a];
+        }
+        else if(opt == "--stats" or opt == "--stats=json")
+        {
+            stats = true;
+            stats_json = opt == "--stats=json";
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    engine_options options;
+    options.algorithm = algorithm;
+    options.threads = threads;
+    options.par = par;
+    options.polygons = not polygons_output.empty();
+    options.transposed = transposed;
+
+    //the workers of --processes are forked, and their statistics stay in them
+    if(processes > 0 and (stats or not memory_trace.empty()))
+    {
+        cerr << "--processes supports neither --stats nor --memory-trace\n";
+        return 1;
+    }
+    if((stats and not stats_enable(stats_json)) or (not memory_trace.empty() and not stats_trace_memory(memory_trace)))
+    {
+        cerr << "statistics are not compiled in, rebuild with -DCONTOURS_STATS\n";
+    }
+
+    if(not batch.empty())
+    {
+        if(tiled or check or measure or processes > 0 or not convert.empty() or not binary_output.empty() or not polygons_output.empty())
+        {
+            cerr << "--batch supports none of --tiled, --check, --measure, --processes, --convert, --binary-output and --polygons\n";
+            return 1;
+        }
+        return run_batch(input, batch, options, threads, not quiet);
+    }
+    if(measure and (tiled or processes > 0))
+    {
+        cerr << "--measure supports neither --tiled, --memory-budget nor --processes\n";
+        return 1;
+    }
+    if(tiled and convert.empty())
+    {
+        if(input == "-" or check or processes > 0 or not binary_output.empty() or not polygons_output.empty())
+        {
+            cerr << "--tiled needs --input FILE and supports none of --check, --processes, --binary-output and --polygons\n";
+            return 1;
+        }
+        return run_tiled(input, tiling, quiet ? string() : output, write_csv, async_output);
+    }
+    vector<rectangle> rects;
+    if(not load_rectangles(input, rects))
+    {
+        return 1;
+    }
+    if(not convert.empty())
+    {
+        return write_binary_rectangles(rects, convert, convert_encoding) ? 0 : 1;
+    }
+    if(measure)
+    {
+        return run_measure(rects, options, output, check);
+    }
+    //rectangles.csv depends on the input alone, so it is written while the contours are computed, or with --processes once the workers are forked, since no other thread may run at the fork
+    future<bool> rectangles_csv;
+    auto start_rectangles_csv = [&]()
+    {
+        if(write_csv)
+        {
+            rectangles_csv = async(launch::async, [&rects]()
+            {
+                output_writer out;
+                if(not out.open("rectangles.csv", false))
+                {
+                    return false;
+                }
+                write_rectangles_csv(out, rects);
+                return out.close();
+            });
+        }
+    };
+    contour_result contours;
+    if(processes > 0)
+    {
+        shard_options sharding;
+        sharding.workers = processes;
+        sharding.engine = options;
+        if(not sharded_contour(rects, sharding, contours))
+        {
+            return 1;
+        }
+        start_rectangles_csv();
+    }
+    else
+    {
+        start_rectangles_csv();
+        contour_engine engine(options);
+        if(not engine.compute(rects.data(), rects.size(), contours))
+        {
+            return 1;
+        }
+    }
+
+    int status = 0;
+    if(check)
+    {
+        engine_options other_options = options;
+        other_options.algorithm = algorithm == ENGINE_SWEEP ? ENGINE_DAC : ENGINE_SWEEP;
+        other_options.transposed = false;
+        contour_engine other_engine(other_options);
+        contour_result other;
+        if(processes > 0 or (transposed and algorithm == ENGINE_DAC))
+        {
+            //the workers and the transposed divide and conquer skip the rectangles without area, so the other engine does too
+            vector<rectangle> with_area;
+            copy_if(rects.begin(), rects.end(), back_inserter(with_area), [](const rectangle& r) { return r.x_int.bottom < r.x_int.top and r.y_int.bottom < r.y_int.top; });
+            other = other_engine.compute(with_area);
+        }
+        else
+        {
+            other = other_engine.compute(rects);
+        }
+        bool same = compare_contours("horizontal", contours.horizontal, other.horizontal);
+        same = compare_contours("vertical", contours.vertical, other.vertical) and same;
+        if(same)
+        {
+            cerr << "engines agree\n";
+        }
+        else
+        {
+            status = 2;
+        }
+        if(consistent_contours(contours.horizontal, contours.vertical))
+        {
+            cerr << "contours are consistent\n";
+        }
+        else
+        {
+            status = 2;
+        }
+    }
+
+    bool written = true;
+    if(not quiet)
+    {
+        output_writer out;
+        written = out.open(output, async_output);
+        if(written)
+        {
+            write_contours_text(out, contours.horizontal, contours.vertical);
+            written = out.close();
+        }
+    }
+    if(not binary_output.empty())
+    {
+        output_writer out;
+        bool ok = out.open(binary_output, async_output);
+        if(ok)
+        {
+            write_contours_binary(out, contours.horizontal, contours.vertical);
+            ok = out.close();
+        }
+        written = ok and written;
+    }
+    if(not polygons_output.empty())
+    {
+        if(contours.polygons.empty() and not contours.horizontal.empty())
+        {
+            cerr << "the contour does not close into polygons; rectangles without area cause this\n";
+        }
+        output_writer out;
+        bool ok = out.open(polygons_output, async_output);
+        if(ok)
+        {
+            write_polygons_text(out, contours.polygons);
+            ok = out.close();
+        }
+        written = ok and written;
+    }
+    if(write_csv)
+    {
+        output_writer out;
+        bool ok = out.open("contours.csv", async_output);
+        if(ok)
+        {
+            write_contours_csv(out, contours.horizontal, contours.vertical);
+            ok = out.close();
+        }
+        written = rectangles_csv.get() and ok and written;
+    }
+    if(not written and status == 0)
+    {
+        status = 1;
+    }
+    return status;
+}
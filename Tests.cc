@@ -0,0 +1,331 @@
+///@file
+///@brief Test driver that checks every engine and mode of the contour library against the others on seeded random inputs and on fixed edge cases
+///
+///Build with: g++ -O2 -std=c++17 -pthread Tests.cc Contours.cc -o tests
+#include "Contours.h"
+#include<bits/stdc++.h>
+#include<unistd.h>
+using namespace std;
+typedef long long int ll;
+
+///Number of checks that failed so far
+size_t failures = 0;
+
+/*! Records the outcome of one check, reporting it to the error stream when it failed
+    \param ok whether the check passed
+    \param what names the check
+    \param seed seed or number of the input the check ran on
+*/
+void expect(bool ok, const string& what, size_t seed)
+{
+    if(not ok)
+    {
+        cerr << "FAIL " << what << " on input " << seed << "\n";
+        failures++;
+    }
+}
+
+/*! Builds a rectangle from its bounds
+    \param x1 left bound
+    \param x2 right bound
+    \param y1 bottom bound
+    \param y2 top bound
+    \param id unique ID of the rectangle
+    \return The rectangle
+*/
+rectangle make_rectangle(ll x1, ll x2, ll y1, ll y2, ll id)
+{
+    rectangle r;
+    r.x_int.bottom = x1;
+    r.x_int.top = x2;
+    r.y_int.bottom = y1;
+    r.y_int.top = y2;
+    r.id = id;
+    return r;
+}
+
+/*! Draws a small set of rectangles on a coarse grid, so that edges often coincide, touch and cross
+    \param rng seeded random generator
+    \param degenerate whether rectangles without width or height are drawn too
+    \param span coordinates are drawn from [-span, span]
+    \return The rectangles, with IDs given in order
+*/
+vector<rectangle> random_rectangles(mt19937_64& rng, bool degenerate, ll span)
+{
+    uniform_int_distribution<ll> count(1, 24), pos(-span, span), len(degenerate ? 0 : 1, span);
+    vector<rectangle> rects;
+    size_t n = count(rng);
+    for(size_t i=0;i<n;i++)
+    {
+        ll x = pos(rng), y = pos(rng);
+        rects.push_back(make_rectangle(x, x+len(rng), y, y+len(rng), i));
+    }
+    return rects;
+}
+
+/*! Keeps the rectangles with positive width and height, which alone take part in the dynamic, tiled, sharded and transposed modes
+    \param rects the rectangles
+    \return The rectangles with area, in order
+*/
+vector<rectangle> with_area(const vector<rectangle>& rects)
+{
+    vector<rectangle> kept;
+    copy_if(rects.begin(), rects.end(), back_inserter(kept), [](const rectangle& r) { return r.x_int.bottom < r.x_int.top and r.y_int.bottom < r.y_int.top; });
+    return kept;
+}
+
+/*! Computes a contour with a fresh engine
+    \param rects the rectangles
+    \param options options of the engine
+    \return The contour
+*/
+contour_result contour_of(const vector<rectangle>& rects, const engine_options& options)
+{
+    contour_engine engine(options);
+    return engine.compute(rects);
+}
+
+/*! Tells whether two contours hold the same segments, reporting the differences to the error stream
+    \param a one contour
+    \param b the other contour
+    \return true when both directions are equal
+*/
+bool same_contours(const contour_result& a, const contour_result& b)
+{
+    bool same = compare_contours("horizontal", a.horizontal, b.horizontal);
+    return compare_contours("vertical", a.vertical, b.vertical) and same;
+}
+
+/*! Checks the divide and conquer, on one thread and on a pool with tiny cutoffs, and with the transposed run, against the sweep, and the union measures against the contour
+    \param rects the rectangles
+    \param seed number of the input, for the reports
+*/
+void check_engines(const vector<rectangle>& rects, size_t seed)
+{
+    engine_options sweep;
+    sweep.algorithm = ENGINE_SWEEP;
+    contour_result expected = contour_of(rects, sweep);
+
+    engine_options dac;
+    expect(same_contours(contour_of(rects, dac), expected), "dac against sweep", seed);
+    engine_options pooled;
+    pooled.threads = 4;
+    pooled.par.dac_cutoff = 1;
+    pooled.par.merge_cutoff = 1;
+    pooled.par.contour_chunk = 1;
+    expect(same_contours(contour_of(rects, pooled), expected), "pooled dac against sweep", seed);
+
+    vector<rectangle> kept = with_area(rects);
+    contour_result kept_expected = contour_of(kept, sweep);
+    engine_options transposed;
+    transposed.transposed = true;
+    contour_result t = contour_of(rects, transposed);
+    expect(same_contours(t, kept_expected), "transposed dac against sweep", seed);
+    expect(consistent_contours(t.horizontal, t.vertical), "consistent transposed contours", seed);
+
+    contour_engine engine(sweep);
+    union_measures m;
+    expect(engine.measure(rects.data(), rects.size(), m), "measure", seed);
+    __int128 area = 0;
+    measure_int horizontal = 0, vertical = 0;
+    for(auto& s : kept_expected.horizontal)
+    {
+        horizontal += uint64_t(s.inter.top)-uint64_t(s.inter.bottom);
+    }
+    for(auto& s : kept_expected.vertical)
+    {
+        vertical += uint64_t(s.inter.top)-uint64_t(s.inter.bottom);
+    }
+    expect(m.horizontal_length == horizontal and m.vertical_length == vertical and m.perimeter == horizontal+vertical and m.vertices == 2*kept_expected.horizontal.size(), "measures against contour", seed);
+
+    //the rings of the contour enclose the union: their signed areas add up to its area
+    vector<contour_polygon> polygons;
+    expect(assemble_polygons(kept_expected.horizontal, kept_expected.vertical, polygons), "assemble polygons", seed);
+    for(const contour_polygon& p : polygons)
+    {
+        ll twice = 0;
+        for(size_t k=0;k<p.vertices.size();k++)
+        {
+            const point& a = p.vertices[k];
+            const point& b = p.vertices[(k+1)%p.vertices.size()];
+            twice += a.x*b.y-b.x*a.y;
+        }
+        expect((twice > 0) == (p.depth%2 == 0), "orientation of polygon", seed);
+        area += twice/2;
+    }
+    expect(area == __int128(m.area), "polygon areas against measured area", seed);
+}
+
+/*! Checks the dynamic contour after every insert and erase of a random sequence against a contour computed from scratch
+    \param rects the rectangles, inserted in order and then erased every other one
+    \param seed number of the input, for the reports
+*/
+void check_dynamic(const vector<rectangle>& rects, size_t seed)
+{
+    dynamic_contour dynamic;
+    contour_delta delta;
+    map<ll, rectangle> live;
+    auto compare = [&]()
+    {
+        vector<rectangle> current;
+        for(auto& kv : live)
+        {
+            current.push_back(kv.second);
+        }
+        contour_result c;
+        dynamic.contour(c);
+        expect(same_contours(c, contour_of(current, engine_options())), "dynamic contour against recomputation", seed);
+    };
+    for(const rectangle& r : with_area(rects))
+    {
+        expect(dynamic.insert(r, delta), "dynamic insert", seed);
+        live[r.id] = r;
+        compare();
+    }
+    for(auto it=live.begin();it!=live.end();)
+    {
+        expect(dynamic.erase(it->first, delta), "dynamic erase", seed);
+        it = live.erase(it);
+        if(it != live.end())
+        {
+            ++it;
+        }
+        compare();
+    }
+}
+
+/*! Makes a temporary file name that is removed again by the caller
+    \param tag distinguishes the files of one run
+    \return The path
+*/
+string temp_path(const char* tag)
+{
+    const char* dir = getenv("TMPDIR");
+    return string(dir != NULL ? dir : "/tmp") + "/contours-test-" + to_string(getpid()) + "-" + tag;
+}
+
+/*! Checks the tiled mode, with a budget small enough to split the frame, against the in-memory contour
+    \param rects the rectangles
+    \param seed number of the input, for the reports
+*/
+void check_tiled(const vector<rectangle>& rects, size_t seed)
+{
+    string path = temp_path("tiled");
+    expect(write_binary_rectangles(rects, path, ENCODING_DELTA), "write tiled input", seed);
+    tiled_options options;
+    options.memory_budget = 1;
+    contour_result tiled;
+    bool ok = tiled_contour(path, options, [&](const line_segment& s, bool horizontal)
+    {
+        (horizontal ? tiled.horizontal : tiled.vertical).push_back(s);
+    });
+    unlink(path.c_str());
+    expect(ok and same_contours(tiled, contour_of(with_area(rects), engine_options())), "tiled against in-memory contour", seed);
+}
+
+/*! Checks that both binary encodings give back exactly the rectangles written, and that malformed varints are refused
+    \param rects the rectangles
+    \param seed number of the input, for the reports
+*/
+void check_binary(const vector<rectangle>& rects, size_t seed)
+{
+    for(binary_encoding encoding : {ENCODING_FIXED, ENCODING_DELTA})
+    {
+        string path = temp_path("binary");
+        vector<rectangle> loaded;
+        bool ok = write_binary_rectangles(rects, path, encoding) and load_rectangles(path, loaded);
+        unlink(path.c_str());
+        ok = ok and loaded.size() == rects.size();
+        for(size_t i=0;ok and i<rects.size();i++)
+        {
+            ok = loaded[i].x_int.bottom == rects[i].x_int.bottom and loaded[i].x_int.top == rects[i].x_int.top and loaded[i].y_int.bottom == rects[i].y_int.bottom and loaded[i].y_int.top == rects[i].y_int.top;
+        }
+        expect(ok, encoding == ENCODING_FIXED ? "fixed binary round trip" : "delta binary round trip", seed);
+    }
+}
+
+/*! Runs the fixed edge cases: coordinates at the limits of 64 bits, rectangles without area, and inputs malformed on purpose
+*/
+void check_edge_cases()
+{
+    const ll lo = numeric_limits<ll>::min(), hi = numeric_limits<ll>::max();
+    vector<vector<rectangle>> cases = {
+        {},
+        {make_rectangle(0, 0, 0, 0, 0)},
+        {make_rectangle(-6, -6, -4, 1, 0), make_rectangle(0, 3, 0, 3, 1)},
+        {make_rectangle(-6, -2, 4, 4, 0), make_rectangle(0, 3, 0, 3, 1)},
+        {make_rectangle(0, 2, 0, 2, 0), make_rectangle(2, 4, 2, 4, 1)},
+        {make_rectangle(0, 4, 0, 4, 0), make_rectangle(1, 3, 1, 3, 1), make_rectangle(0, 4, 0, 4, 2)},
+        {make_rectangle(lo, hi, lo, hi, 0)},
+        {make_rectangle(lo, lo+1, hi-1, hi, 0), make_rectangle(hi-1, hi, lo, lo+1, 1)},
+        {make_rectangle(lo+2, hi-2, lo+2, hi-2, 0), make_rectangle(-1, 1, -1, 1, 1)},
+        {make_rectangle(-5000000000000000000, 5000000000000000000, 0, 1, 0), make_rectangle(-4000000000000000000, 4000000000000000000, -4000000000000000000, 4000000000000000000, 1)},
+    };
+    for(size_t c=0;c<cases.size();c++)
+    {
+        engine_options sweep;
+        sweep.algorithm = ENGINE_SWEEP;
+        expect(same_contours(contour_of(cases[c], engine_options()), contour_of(cases[c], sweep)), "edge case dac against sweep", c);
+        engine_options transposed;
+        transposed.transposed = true;
+        contour_result t = contour_of(cases[c], transposed);
+        expect(consistent_contours(t.horizontal, t.vertical), "edge case consistent transposed contours", c);
+        check_binary(cases[c], c);
+    }
+
+    //squares whose measures pass the range of ll, up to the whole plane
+    const measure_int sides[] = {8000000000000000000ULL, 1ULL<<63, ~0ULL};
+    const ll corners[] = {-4000000000000000000, -(1LL<<62), lo};
+    for(size_t c=0;c<3;c++)
+    {
+        vector<rectangle> square = {make_rectangle(corners[c], ll(uint64_t(corners[c])+uint64_t(sides[c])), corners[c], ll(uint64_t(corners[c])+uint64_t(sides[c])), 0)};
+        contour_engine engine;
+        union_measures m;
+        expect(engine.measure(square.data(), square.size(), m) and m.area == sides[c]*sides[c] and m.perimeter == 4*sides[c] and m.horizontal_length == 2*sides[c] and m.vertices == 4, "exact measures of a square at the limits", c);
+        //the outer ring runs counterclockwise from the lower left corner
+        engine_options polygons;
+        polygons.polygons = true;
+        contour_result r = contour_of(square, polygons);
+        const ll far = square[0].x_int.top;
+        expect(r.polygons.size() == 1 and r.polygons[0].vertices.size() == 4 and r.polygons[0].vertices[1].x == far and r.polygons[0].vertices[1].y == corners[c] and r.polygons[0].vertices[3].x == corners[c] and r.polygons[0].vertices[3].y == far, "counterclockwise ring of a square at the limits", c);
+    }
+
+    //a tenth varint byte may only hold bit 63
+    const unsigned char overlong[] = {'C','O','N','T','R','E','C','T', 1,0,0,0, 1,0,0,0, 1,0,0,0,0,0,0,0, 0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0x7f, 0,0,0};
+    vector<rectangle> rects;
+    expect(not parse_rectangles((const char*)overlong, (const char*)overlong+sizeof(overlong), rects), "overlong varint refused", 0);
+    const char text[] = "1\n0 1 0 99999999999999999999\n";
+    expect(not parse_rectangles(text, text+sizeof(text)-1, rects), "integer beyond 64 bits refused", 0);
+}
+
+int main(int argc, char** argv)
+{
+    size_t inputs = argc > 1 ? max(atoll(argv[1]),1LL) : 200;
+
+    //the workers of sharded_contour are forked, so it runs before any other test starts a thread
+    for(size_t seed=0;seed<inputs/10;seed++)
+    {
+        mt19937_64 rng(seed);
+        vector<rectangle> rects = random_rectangles(rng, true, 16);
+        shard_options options;
+        options.workers = 3;
+        contour_result sharded;
+        expect(sharded_contour(rects, options, sharded) and same_contours(sharded, contour_of(with_area(rects), engine_options())), "sharded against in-memory contour", seed);
+    }
+
+    check_edge_cases();
+    for(size_t seed=0;seed<inputs;seed++)
+    {
+        mt19937_64 rng(seed);
+        vector<rectangle> rects = random_rectangles(rng, true, seed%2 ? 8 : 1000);
+        check_engines(rects, seed);
+        check_binary(rects, seed);
+        if(seed%4 == 0)
+        {
+            check_dynamic(rects, seed);
+            check_tiled(rects, seed);
+        }
+    }
+    cerr << (failures == 0 ? "all tests passed\n" : to_string(failures) + " checks failed\n");
+    return failures == 0 ? 0 : 1;
+}